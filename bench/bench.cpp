@@ -0,0 +1,354 @@
+#include <imgui.h>
+#include <dibs/bridge.hpp>
+#include <dibs/dibs.hpp>
+#include <dibs/dibs_version.hpp>
+#include <dibs/pixels.hpp>
+#include <dibs/stats.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+using Ms = std::chrono::duration<double, std::milli>;
+
+struct Options {
+	std::string json;
+	std::string only;
+	std::uint32_t frames = 500U;
+	std::uint32_t startups = 5U;
+	std::uint32_t flood = 1000U;
+};
+
+struct Result {
+	std::string name;
+	std::vector<double> samples; // ms
+	std::vector<std::pair<std::string, double>> extra;
+};
+
+double percentile(std::vector<double> sorted, double const p) {
+	if (sorted.empty()) { return 0.0; }
+	std::sort(sorted.begin(), sorted.end());
+	auto const rank = std::size_t(p * double(sorted.size() - 1U) + 0.5);
+	return sorted[std::min(rank, sorted.size() - 1U)];
+}
+
+double mean(std::vector<double> const& samples) {
+	if (samples.empty()) { return 0.0; }
+	double sum{};
+	for (double const s : samples) { sum += s; }
+	return sum / double(samples.size());
+}
+
+// mean GPU time of the frames in the rolling history
+double gpuMean(dibs::Instance const& instance) {
+	auto const& gpu = instance.stats().gpu;
+	if (gpu.empty()) { return 0.0; }
+	double sum{};
+	for (std::size_t i = 0; i < gpu.size(); ++i) { sum += gpu[i].ms; }
+	return sum / double(gpu.size());
+}
+
+template <typename F>
+double timed(F&& f) {
+	auto const start = Clock::now();
+	f();
+	return Ms(Clock::now() - start).count();
+}
+
+dibs::Result<dibs::Instance> makeInstance() { return dibs::Instance::Builder().title("dibs-bench").extent({1280U, 720U})(); }
+
+template <typename F>
+void frame(dibs::Instance& instance, F&& draw) {
+	instance.poll();
+	auto frame = dibs::Frame(instance);
+	draw();
+}
+
+void frame(dibs::Instance& instance) {
+	frame(instance, [] {});
+}
+
+Result instanceStartup(Options const& options) {
+	// build, first frame, and teardown
+	Result ret{"instance_startup", {}, {}};
+	std::vector<double> teardown;
+	for (std::uint32_t i = 0; i < options.startups; ++i) {
+		auto start = Clock::now();
+		ret.samples.push_back(timed([&] {
+			auto instance = makeInstance();
+			if (!instance) { return; }
+			frame(*instance);
+			start = Clock::now();
+		}));
+		teardown.push_back(Ms(Clock::now() - start).count());
+	}
+	ret.extra.push_back({"teardown_mean_ms", mean(teardown)});
+	return ret;
+}
+
+Result emptyFrame(dibs::Instance& instance, Options const& options) {
+	Result ret{"empty_frame", {}, {}};
+	for (std::uint32_t i = 0; i < options.frames; ++i) {
+		ret.samples.push_back(timed([&] { frame(instance); }));
+	}
+	ret.extra.push_back({"fps", 1000.0 / mean(ret.samples)});
+	ret.extra.push_back({"gpu_mean_ms", gpuMean(instance)});
+	return ret;
+}
+
+Result imguiDemo(dibs::Instance& instance, Options const& options) {
+	Result ret{"imgui_demo", {}, {}};
+	for (std::uint32_t i = 0; i < options.frames; ++i) {
+		ret.samples.push_back(timed([&] { frame(instance, [] { ImGui::ShowDemoWindow(); }); }));
+	}
+	ret.extra.push_back({"fps", 1000.0 / mean(ret.samples)});
+	ret.extra.push_back({"gpu_mean_ms", gpuMean(instance)});
+	return ret;
+}
+
+void imguiRenderers(std::vector<Result>& out, dibs::Instance& instance, Options const& options) {
+	// A/B: the same data-heavy window drawn by dibs' renderer and by the stock backend
+	auto const heavy = [] {
+		ImGui::SetNextWindowPos({0.0f, 0.0f});
+		ImGui::SetNextWindowSize({1280.0f, 720.0f});
+		ImGui::Begin("dibs-bench", nullptr, ImGuiWindowFlags_NoDecoration);
+		auto* const list = ImGui::GetWindowDrawList();
+		for (int i = 0; i < 120000; ++i) {
+			auto const x = float(i % 400) * 3.2f, y = float(i / 400) * 2.4f;
+			list->AddRectFilled({x, y}, {x + 2.0f, y + 2.0f}, IM_COL32(i % 255, (i / 7) % 255, 128, 255));
+		}
+		for (int i = 0; i < 400; ++i) { ImGui::Text("row %d: %f", i, double(i) * 0.5); }
+		ImGui::End();
+	};
+	std::pair<dibs::UiRenderer, std::string_view> const renderers[] = {{dibs::UiRenderer::eNative, "native"}, {dibs::UiRenderer::eBackend, "backend"}};
+	auto const previous = instance.uiRenderer();
+	for (auto const& [renderer, name] : renderers) {
+		instance.uiRenderer(renderer);
+		Result result{"imgui_heavy_" + std::string(name), {}, {}};
+		for (std::uint32_t i = 0; i < options.frames; ++i) {
+			result.samples.push_back(timed([&] { frame(instance, heavy); }));
+		}
+		auto const* data = ImGui::GetDrawData();
+		result.extra.push_back({"vertices", data ? double(data->TotalVtxCount) : 0.0});
+		result.extra.push_back({"gpu_mean_ms", gpuMean(instance)});
+		out.push_back(std::move(result));
+	}
+	instance.uiRenderer(previous);
+}
+
+Result pollFlood(dibs::Instance& instance, Options const& options) {
+	// warping the cursor inside the window makes the server deliver real motion events to the next poll
+	Result ret{"poll_flood", {}, {}};
+	auto const window = dibs::Bridge::glfw(instance);
+	auto const size = instance.windowSize();
+	std::size_t events{};
+	for (std::uint32_t i = 0; i < options.frames / 4U; ++i) {
+		for (std::uint32_t j = 0; j < options.flood; ++j) {
+			glfwSetCursorPos(window, double(j % size.x), double((j / size.x) % size.y));
+		}
+		dibs::Poll poll;
+		ret.samples.push_back(timed([&] { poll = instance.poll(); }));
+		events += poll.events.size();
+		{ auto frame = dibs::Frame(instance); }
+	}
+	ret.extra.push_back({"injected_per_poll", double(options.flood)});
+	ret.extra.push_back({"events_per_poll", ret.samples.empty() ? 0.0 : double(events) / double(ret.samples.size())});
+	return ret;
+}
+
+Result swapchainRecreate(dibs::Instance& instance, Options const& options) {
+	// alternate window sizes; the following frame observes a stale swapchain and recreates it
+	Result ret{"swapchain_recreate", {}, {}};
+	auto const window = dibs::Bridge::glfw(instance);
+	dibs::uvec2 const sizes[] = {{1280U, 720U}, {960U, 540U}};
+	for (std::uint32_t i = 0; i < options.frames / 10U; ++i) {
+		auto const size = sizes[i % 2U];
+		glfwSetWindowSize(window, int(size.x), int(size.y));
+		ret.samples.push_back(timed([&] {
+			for (int j = 0; j < 2 && instance.framebufferSize().x != size.x; ++j) { glfwWaitEventsTimeout(0.01); }
+			frame(instance);
+			frame(instance);
+		}));
+	}
+	return ret;
+}
+
+void dispatchOverhead(std::vector<Result>& out, dibs::Instance& instance, Options const& options) {
+	// A/B: vkGetFenceStatus resolved through the instance (loader trampoline) and through the device (dibs' dispatch)
+	static constexpr std::uint32_t calls_v = 100000U;
+	auto const& vkd = dibs::Bridge::vulkan(instance);
+	auto const& dispatch = dibs::Bridge::dispatch(instance);
+	auto const device = static_cast<VkDevice>(vkd.device);
+	auto const fence = vkd.device.createFenceUnique({});
+	auto const vkFence = static_cast<VkFence>(*fence);
+	std::pair<PFN_vkVoidFunction, std::string_view> const paths[] = {
+		{dispatch.vkGetInstanceProcAddr(static_cast<VkInstance>(vkd.instance), "vkGetFenceStatus"), "instance"},
+		{dispatch.vkGetDeviceProcAddr(device, "vkGetFenceStatus"), "device"},
+	};
+	for (auto const& [fn, name] : paths) {
+		if (!fn) { continue; }
+		auto const getFenceStatus = reinterpret_cast<PFN_vkGetFenceStatus>(fn);
+		Result result{"dispatch_" + std::string(name), {}, {}};
+		for (std::uint32_t i = 0; i < std::max(options.frames / 10U, 1U); ++i) {
+			result.samples.push_back(timed([&] {
+				for (std::uint32_t j = 0; j < calls_v; ++j) { getFenceStatus(device, vkFence); }
+			}));
+		}
+		result.extra.push_back({"ns_per_call", mean(result.samples) * 1e6 / double(calls_v)});
+		out.push_back(std::move(result));
+	}
+}
+
+// every kernel's output at the current level, over an odd extent that leaves vector tails
+struct PixelOutputs {
+	std::vector<std::uint8_t> swizzle, pack, premultiply, downscale;
+	std::vector<float> linear;
+};
+
+PixelOutputs pixelOutputs() {
+	static constexpr dibs::uvec2 extent_v{1021U, 509U};
+	std::size_t const count = std::size_t(extent_v.x) * extent_v.y;
+	std::vector<std::uint8_t> bytes(count * 4U);
+	std::vector<float> floats(count * 4U);
+	for (std::size_t i = 0; i < bytes.size(); ++i) {
+		bytes[i] = static_cast<std::uint8_t>(i * 7U + i / 251U);
+		// includes values outside [0, 1] to exercise clamping
+		floats[i] = static_cast<float>(bytes[i]) / 230.0f - 0.05f;
+	}
+	auto const halved = dibs::pixels::halved(extent_v);
+	PixelOutputs ret{std::vector<std::uint8_t>(bytes.size()), std::vector<std::uint8_t>(bytes.size()), std::vector<std::uint8_t>(bytes.size()),
+					 std::vector<std::uint8_t>(std::size_t(halved.x) * halved.y * 4U), std::vector<float>(floats.size())};
+	dibs::pixels::swizzle(bytes, ret.swizzle);
+	dibs::pixels::pack(floats, ret.pack);
+	dibs::pixels::premultiply(bytes, ret.premultiply);
+	dibs::pixels::downscale({bytes, extent_v}, ret.downscale);
+	dibs::pixels::srgbToLinear(bytes, ret.linear);
+	return ret;
+}
+
+// false on any mismatch with the scalar reference
+bool pixelsMatch(PixelOutputs const& reference, dibs::SimdLevel const level) {
+	auto const outputs = pixelOutputs();
+	bool ret = true;
+	auto const check = [&](std::string_view const kernel, bool const equal) {
+		if (equal) { return; }
+		std::cerr << "dibs-bench: pixels " << kernel << " (" << dibs::pixels::simdName(level) << ") does not match scalar\n";
+		ret = false;
+	};
+	check("swizzle", outputs.swizzle == reference.swizzle);
+	check("pack", outputs.pack == reference.pack);
+	check("premultiply", outputs.premultiply == reference.premultiply);
+	check("downscale", outputs.downscale == reference.downscale);
+	check("srgb_to_linear", outputs.linear == reference.linear);
+	return ret;
+}
+
+bool pixelKernels(std::vector<Result>& out, Options const& options) {
+	// CPU only: each kernel over a 4K frame at every instruction set this machine supports, verified against scalar
+	std::size_t const count = 3840U * 2160U;
+	std::vector<std::uint8_t> bytes(count * 4U), dst(count * 4U);
+	std::vector<float> floats(count * 4U), linear(count * 4U);
+	for (std::size_t i = 0; i < bytes.size(); ++i) {
+		bytes[i] = static_cast<std::uint8_t>(i * 7U);
+		floats[i] = static_cast<float>(bytes[i]) / 255.0f;
+	}
+	auto const best = dibs::pixels::simd();
+	dibs::pixels::simd(dibs::SimdLevel::eScalar);
+	auto const reference = pixelOutputs();
+	bool ret = true;
+	dibs::SimdLevel const levels[] = {dibs::SimdLevel::eScalar, dibs::SimdLevel::eSse2, dibs::SimdLevel::eAvx2, dibs::SimdLevel::eNeon};
+	for (auto const level : levels) {
+		if (dibs::pixels::simd(level) != level) { continue; }
+		if (!pixelsMatch(reference, level)) { ret = false; }
+		auto const run = [&](std::string_view name, double const bytesMoved, auto&& kernel) {
+			Result result{"pixels_" + std::string(name) + "_" + dibs::pixels::simdName(level), {}, {}};
+			for (std::uint32_t i = 0; i < std::max(options.frames / 10U, 1U); ++i) { result.samples.push_back(timed(kernel)); }
+			result.extra.push_back({"gb_per_s", bytesMoved / (mean(result.samples) * 1e6)});
+			out.push_back(std::move(result));
+		};
+		// bytes read + written
+		run("swizzle", double(count) * 8.0, [&] { dibs::pixels::swizzle(bytes, dst); });
+		run("pack", double(count) * 20.0, [&] { dibs::pixels::pack(floats, dst); });
+		run("srgb_to_linear", double(count) * 20.0, [&] { dibs::pixels::srgbToLinear(bytes, linear); });
+		run("premultiply", double(count) * 8.0, [&] { dibs::pixels::premultiply(bytes, dst); });
+		run("downscale", double(count) * 5.0, [&] { dibs::pixels::downscale({bytes, {3840U, 2160U}}, dst); });
+	}
+	dibs::pixels::simd(best);
+	return ret;
+}
+
+std::string json(std::vector<Result> const& results) {
+	std::ostringstream str;
+	str << "{\n  \"dibs\": \"" << dibs::version << "\",\n  \"results\": [";
+	bool first = true;
+	for (auto const& result : results) {
+		str << (first ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"samples\": " << result.samples.size();
+		str << ", \"mean_ms\": " << mean(result.samples) << ", \"p50_ms\": " << percentile(result.samples, 0.50);
+		str << ", \"p95_ms\": " << percentile(result.samples, 0.95) << ", \"p99_ms\": " << percentile(result.samples, 0.99);
+		for (auto const& [key, value] : result.extra) { str << ", \"" << key << "\": " << value; }
+		str << "}";
+		first = false;
+	}
+	str << "\n  ]\n}\n";
+	return str.str();
+}
+
+bool parse(Options& out, int argc, char const* const argv[]) {
+	for (int i = 1; i < argc; ++i) {
+		std::string_view const arg = argv[i];
+		auto const value = [&]() -> char const* { return i + 1 < argc ? argv[++i] : ""; };
+		if (arg == "--json") {
+			out.json = value();
+		} else if (arg == "--only") {
+			out.only = value();
+		} else if (arg == "--frames") {
+			out.frames = std::uint32_t(std::stoul(value()));
+		} else if (arg == "--startups") {
+			out.startups = std::uint32_t(std::stoul(value()));
+		} else if (arg == "--flood") {
+			out.flood = std::uint32_t(std::stoul(value()));
+		} else {
+			std::cerr << "usage: dibs-bench [--json <path>] [--only <scenario>] [--frames <count>] [--startups <count>] [--flood <events>]\n";
+			return false;
+		}
+	}
+	return true;
+}
+} // namespace
+
+int main(int argc, char const* const argv[]) {
+	Options options;
+	if (!parse(options, argc, argv)) { return 1; }
+	std::vector<Result> results;
+	auto const run = [&](std::string_view name) { return options.only.empty() || options.only == name; };
+	if (run("instance_startup")) { results.push_back(instanceStartup(options)); }
+	bool valid = true;
+	if (run("pixels")) { valid = pixelKernels(results, options); }
+	auto instance = makeInstance();
+	if (!instance) {
+		std::cerr << "fail! error: " << (int)instance.error() << '\n';
+		return 1;
+	}
+	// warm up
+	for (int i = 0; i < 10; ++i) { frame(*instance); }
+	if (run("empty_frame")) { results.push_back(emptyFrame(*instance, options)); }
+	if (run("imgui_demo")) { results.push_back(imguiDemo(*instance, options)); }
+	if (run("imgui_renderers")) { imguiRenderers(results, *instance, options); }
+	if (run("poll_flood")) { results.push_back(pollFlood(*instance, options)); }
+	if (run("swapchain_recreate")) { results.push_back(swapchainRecreate(*instance, options)); }
+	if (run("dispatch")) { dispatchOverhead(results, *instance, options); }
+	auto const report = json(results);
+	if (options.json.empty()) {
+		std::cout << report;
+	} else {
+		std::ofstream(options.json) << report;
+		std::cerr << "dibs-bench: wrote " << options.json << '\n';
+	}
+	return valid ? 0 : 1;
+}
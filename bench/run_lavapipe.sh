@@ -0,0 +1,22 @@
+#!/bin/sh
+# Runs dibs-bench on a software Vulkan device (Mesa lavapipe) inside a virtual X server.
+# Requires: xvfb, mesa-vulkan-drivers
+# Usage: bench/run_lavapipe.sh <path/to/dibs-bench> [dibs-bench args...]
+
+set -e
+
+if [ -z "$1" ]; then
+  echo "Usage: $0 <path/to/dibs-bench> [args...]"
+  exit 1
+fi
+
+bench=$1
+shift
+
+icd=$(ls /usr/share/vulkan/icd.d/lvp_icd.*.json 2>/dev/null | head -n 1)
+if [ -z "$icd" ]; then
+  echo "lavapipe ICD not found (install mesa-vulkan-drivers)"
+  exit 1
+fi
+
+VK_ICD_FILENAMES=$icd xvfb-run -a -s "-screen 0 1920x1080x24" "$bench" "$@"
@@ -3,6 +3,16 @@ target_sources(${PROJECT_NAME} PRIVATE
   include/dibs/dibs.hpp
   include/dibs/error.hpp
   include/dibs/event.hpp
+  include/dibs/frame_export.hpp
+  include/dibs/frame_graph.hpp
+  include/dibs/jobs.hpp
+  include/dibs/log.hpp
+  include/dibs/pipelines.hpp
+  include/dibs/pixels.hpp
+  include/dibs/profile.hpp
   include/dibs/rgba.hpp
+  include/dibs/stats.hpp
+  include/dibs/stats_export.hpp
+  include/dibs/task.hpp
   include/dibs/vec2.hpp
 )
@@ -1,23 +1,23 @@
 #include <imgui.h>				 // Dear ImGui
 #include <dibs/dibs.hpp>		 // primary header
 #include <dibs/dibs_version.hpp> // version
+#include <dibs/stats.hpp>		 // frame / GPU statistics
+#include <dibs/task.hpp>		 // coroutines
 #include <ktl/kformat.hpp>
 #include <iostream>
+#include <thread>
 
 namespace {
 struct DibsWindow {
 	struct {
 		dibs::MouseXY cursor{};
-		std::chrono::duration<float> elapsed{};
 		std::uint32_t frame{};
-		std::uint32_t lastFrame{};
-		std::uint32_t fps{};
 		dibs::RGBA clear = {0x66, 0x33, 0x33};
 	} state;
 	bool imguiDemo = true;
+	bool stats = false;
 
 	void update(dibs::Poll const& poll) noexcept {
-		using namespace std::chrono_literals;
 		using Type = dibs::Event::Type;
 		for (auto const event : poll.events) {
 			switch (event.type()) {
@@ -31,19 +31,15 @@ struct DibsWindow {
 			default: break;
 			}
 		}
-		state.elapsed += poll.dt;
 		++state.frame;
-		if (state.elapsed >= 1s) {
-			state.elapsed = {};
-			state.fps = state.frame - std::exchange(state.lastFrame, state.frame);
-		}
 	}
 
-	void draw() {
+	void draw(dibs::Stats const& frameStats) {
 		static int s_reset = 0;
 		ImGui::SetNextWindowSize({300.0f, 200.0f}, ImGuiCond_Once);
 		if (ImGui::Begin("dibs")) {
-			ImGui::Text("FPS: %u", state.fps);
+			using Metric = dibs::FrameStats::Metric;
+			ImGui::Text("FPS: %.0f (p99: %.1f ms)", frameStats.frames.fps(), frameStats.frames.percentile(Metric::eInterval, 0.99f));
 			ImGui::Text("Cursor: %f, %f", state.cursor.x, state.cursor.y);
 			ImGui::Text("Frame: %6u", state.frame);
 			ImGui::Separator();
@@ -57,11 +53,28 @@ struct DibsWindow {
 			ImGui::SameLine();
 			std::string_view const text = imguiDemo ? "Hide" : "Show";
 			if (ImGui::Button(ktl::kformat("{} ImGui Demo", text.data()).data())) { imguiDemo = !imguiDemo; }
+			ImGui::SameLine();
+			if (ImGui::Button("Stats")) { stats = !stats; }
 		}
 		ImGui::End();
 		if (imguiDemo) { ImGui::ShowDemoWindow(&imguiDemo); }
+		if (stats) { dibs::showStats(frameStats, &stats); }
 	}
 };
+// long-running work without blocking the render loop
+dibs::Task loadAssets(dibs::Instance& instance) {
+	// runs on a background thread; resumed in a later poll()
+	co_await instance.background([] { std::this_thread::sleep_for(std::chrono::seconds(2)); });
+	// resumed in each subsequent Frame, with Dear ImGui ready
+	for (int i = 0; i < 300; ++i) {
+		auto const& frame = co_await instance.nextFrame();
+		if (!frame.ready()) { continue; }
+		ImGui::SetNextWindowPos({20.0f, 240.0f}, ImGuiCond_Once);
+		ImGui::Begin("Task");
+		ImGui::Text("Assets loaded (frame %llu)", static_cast<unsigned long long>(frame.id()));
+		ImGui::End();
+	}
+}
 } // namespace
 
 int main() {
@@ -76,12 +89,13 @@ int main() {
 	}
 	// start main loop
 	DibsWindow window;
+	instance->spawn(loadAssets(*instance));
 	while (!instance->closing()) {
 		// poll events (and obtain delta time if required)
 		window.update(instance->poll());
 		// start a new frame with the given clear colour
 		auto frame = dibs::Frame(*instance, window.state.clear);
 		// draw
-		window.draw();
+		window.draw(instance->stats());
 	}
 }
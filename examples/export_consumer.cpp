@@ -0,0 +1,243 @@
+// Consumer for Builder::exportFrames: connects to the socket given on the command line, imports the shared images and releases each
+// frame once it has been "read" (here: a checksum of the first row in shared memory mode; a queue ownership acquire in external memory mode)
+#include <dibs/frame_export.hpp>
+#include <vulkan/vulkan.hpp>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace {
+namespace fe = dibs::frame_export;
+
+struct Message {
+	std::byte bytes[fe::max_message_v]{};
+	std::size_t size{};
+	std::vector<int> fds;
+
+	fe::Type type() const noexcept {
+		fe::Type ret{};
+		std::memcpy(&ret, bytes, sizeof(ret));
+		return ret;
+	}
+
+	template <typename T>
+	T as() const noexcept {
+		T ret;
+		std::memcpy(&ret, bytes, sizeof(T));
+		return ret;
+	}
+};
+
+std::optional<Message> receive(int const fd) {
+	Message ret;
+	iovec iov{ret.bytes, sizeof(ret.bytes)};
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 2U * fe::max_images_v)]{};
+	msghdr msg{};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1U;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	auto const received = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+	if (received <= 0) { return std::nullopt; }
+	ret.size = static_cast<std::size_t>(received);
+	for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) { continue; }
+		auto const count = (cmsg->cmsg_len - CMSG_LEN(0U)) / sizeof(int);
+		ret.fds.resize(count);
+		std::memcpy(ret.fds.data(), CMSG_DATA(cmsg), count * sizeof(int));
+	}
+	return ret;
+}
+
+bool release(int const fd, fe::Frame const& frame) {
+	auto message = fe::Release{};
+	message.generation = frame.generation;
+	message.index = frame.index;
+	return ::send(fd, &message, sizeof(message), MSG_NOSIGNAL) == static_cast<ssize_t>(sizeof(message));
+}
+
+// eSharedMemory
+struct SharedImages {
+	std::byte const* mapped{};
+	std::size_t bytes{};
+
+	SharedImages() = default;
+	SharedImages(SharedImages&&) = delete;
+	SharedImages& operator=(SharedImages&&) = delete;
+	~SharedImages() { reset(); }
+
+	bool import(fe::Config const& config, int const fd) {
+		reset();
+		bytes = static_cast<std::size_t>(config.size) * config.count;
+		auto* const ret = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (ret == MAP_FAILED) { return false; }
+		mapped = static_cast<std::byte const*>(ret);
+		return true;
+	}
+
+	void reset() {
+		if (mapped) { ::munmap(const_cast<std::byte*>(mapped), bytes); }
+		mapped = {};
+	}
+};
+
+// eExternalMemory
+struct ExternalImages {
+	struct Image {
+		vk::UniqueDeviceMemory memory;
+		vk::UniqueImage image;
+		vk::UniqueSemaphore semaphore;
+	};
+
+	vk::DynamicLoader loader;
+	vk::UniqueInstance instance;
+	vk::PhysicalDevice gpu;
+	vk::UniqueDevice device;
+	vk::Queue queue;
+	std::uint32_t family{};
+	vk::UniqueCommandPool pool;
+	vk::CommandBuffer cb;
+	vk::UniqueFence fence;
+	std::vector<Image> images;
+
+	bool init(fe::Config const& config) {
+		VULKAN_HPP_DEFAULT_DISPATCHER.init(loader.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr"));
+		vk::ApplicationInfo app("dibs-export-consumer", 1U, nullptr, 0U, VK_API_VERSION_1_1);
+		instance = vk::createInstanceUnique(vk::InstanceCreateInfo({}, &app));
+		VULKAN_HPP_DEFAULT_DISPATCHER.init(*instance);
+		for (auto const& each : instance->enumeratePhysicalDevices()) {
+			auto const ids = each.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>().get<vk::PhysicalDeviceIDProperties>();
+			if (std::memcmp(ids.deviceUUID.data(), config.deviceUuid, sizeof(config.deviceUuid)) == 0 &&
+				std::memcmp(ids.driverUUID.data(), config.driverUuid, sizeof(config.driverUuid)) == 0) {
+				gpu = each;
+			}
+		}
+		if (!gpu) {
+			std::cerr << "No physical device matches the exporter's UUIDs\n";
+			return false;
+		}
+		auto const families = gpu.getQueueFamilyProperties();
+		for (family = 0U; family < families.size(); ++family) {
+			if (families[family].queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)) { break; }
+		}
+		float const priority = 1.0f;
+		vk::DeviceQueueCreateInfo const queueInfo({}, family, 1U, &priority);
+		char const* extensions[] = {VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME, VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME};
+		device = gpu.createDeviceUnique(vk::DeviceCreateInfo({}, queueInfo, {}, extensions));
+		VULKAN_HPP_DEFAULT_DISPATCHER.init(*device);
+		queue = device->getQueue(family, 0U);
+		pool = device->createCommandPoolUnique(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, family));
+		cb = device->allocateCommandBuffers(vk::CommandBufferAllocateInfo(*pool, vk::CommandBufferLevel::ePrimary, 1U)).front();
+		fence = device->createFenceUnique({});
+		return true;
+	}
+
+	bool import(fe::Config const& config, std::vector<int> const& fds) {
+		if (!device && !init(config)) { return false; }
+		device->waitIdle();
+		images.clear();
+		for (std::uint32_t i = 0; i < config.count; ++i) {
+			auto& image = images.emplace_back();
+			vk::ExternalMemoryImageCreateInfo const external(vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd);
+			vk::ImageCreateInfo info;
+			info.pNext = &external;
+			info.imageType = vk::ImageType::e2D;
+			info.format = static_cast<vk::Format>(config.format);
+			info.extent = vk::Extent3D(config.width, config.height, 1U);
+			info.mipLevels = info.arrayLayers = 1U;
+			info.usage = static_cast<vk::ImageUsageFlags>(config.usage);
+			image.image = device->createImageUnique(info);
+			// opaque fds import with the exporter's memory type, size and dedication; the implementation owns each fd once imported
+			vk::MemoryDedicatedAllocateInfo const dedicated(*image.image);
+			vk::ImportMemoryFdInfoKHR const imported(vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd, fds[i], config.dedicated ? &dedicated : nullptr);
+			image.memory = device->allocateMemoryUnique(vk::MemoryAllocateInfo(config.size, config.memoryType, &imported));
+			device->bindImageMemory(*image.image, *image.memory, 0U);
+			image.semaphore = device->createSemaphoreUnique({});
+			device->importSemaphoreFdKHR(vk::ImportSemaphoreFdInfoKHR(*image.semaphore, {}, vk::ExternalSemaphoreHandleTypeFlagBits::eOpaqueFd, fds[config.count + i]));
+		}
+		return true;
+	}
+
+	// waits on the frame's semaphore and acquires the image: sample / copy it in the same command buffer
+	void read(fe::Frame const& frame) {
+		auto const& image = images[frame.index];
+		cb.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+		vk::ImageMemoryBarrier acquire;
+		acquire.image = *image.image;
+		acquire.oldLayout = acquire.newLayout = vk::ImageLayout::eGeneral;
+		acquire.srcQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+		acquire.dstQueueFamilyIndex = family;
+		acquire.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead;
+		acquire.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0U, 1U, 0U, 1U);
+		cb.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands, {}, {}, {}, acquire);
+		cb.end();
+		auto const semaphore = *image.semaphore;
+		vk::PipelineStageFlags const stage = vk::PipelineStageFlagBits::eAllCommands;
+		queue.submit(vk::SubmitInfo(semaphore, stage, cb), *fence);
+		static_cast<void>(device->waitForFences(*fence, true, std::numeric_limits<std::uint64_t>::max()));
+		device->resetFences(*fence);
+	}
+};
+} // namespace
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <socket path>\n";
+		return 1;
+	}
+	sockaddr_un address{};
+	std::string_view const path = argv[1];
+	if (path.size() >= sizeof(address.sun_path)) { return 1; }
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.data(), path.size());
+	auto const fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0) {
+		std::cerr << "Failed to connect to " << path << '\n';
+		return 1;
+	}
+	auto config = fe::Config{};
+	SharedImages shared;
+	ExternalImages external;
+	while (auto const message = receive(fd)) {
+		if (message->type() == fe::Type::eConfig && message->size >= sizeof(fe::Config)) {
+			config = message->as<fe::Config>();
+			if (config.magic != fe::magic_v || config.version != fe::version_v) {
+				std::cerr << "Protocol mismatch\n";
+				return 1;
+			}
+			bool const isExternal = config.mode == fe::Mode::eExternalMemory;
+			bool const imported = isExternal ? message->fds.size() == 2U * config.count && external.import(config, message->fds)
+											 : message->fds.size() == 1U && shared.import(config, message->fds.front());
+			if (!imported) {
+				std::cerr << "Failed to import images\n";
+				return 1;
+			}
+			std::cout << "Generation " << config.generation << ": " << config.count << " images, " << config.width << "x" << config.height
+					  << (isExternal ? " (external memory)\n" : " (shared memory)\n");
+		} else if (message->type() == fe::Type::eFrame && message->size >= sizeof(fe::Frame)) {
+			auto const frame = message->as<fe::Frame>();
+			if (frame.generation != config.generation || frame.index >= config.count) { continue; }
+			std::cout << "Frame " << frame.frame << " in image " << frame.index;
+			if (config.mode == fe::Mode::eExternalMemory) {
+				external.read(frame);
+			} else {
+				auto const* const bytes = shared.mapped + static_cast<std::size_t>(config.size) * frame.index;
+				std::uint32_t checksum{};
+				for (std::size_t i = 0; i < config.size / config.height; ++i) { checksum = checksum * 31U + std::to_integer<std::uint32_t>(bytes[i]); }
+				std::cout << ", first row checksum " << checksum;
+			}
+			std::cout << '\n';
+			if (!release(fd, frame)) { break; }
+		}
+	}
+	std::cout << "Disconnected\n";
+	::close(fd);
+}
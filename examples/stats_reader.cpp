@@ -0,0 +1,65 @@
+// Monitor for Builder::exportStats / DIBS_STATS_SHM: prints the segment's values once per interval until its process exits
+#include <dibs/stats_export.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <signal.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace {
+namespace se = dibs::stats_export;
+
+double mib(std::uint64_t const bytes) { return double(bytes) / (1024.0 * 1024.0); }
+unsigned long long ull(std::uint64_t const value) { return static_cast<unsigned long long>(value); }
+
+void print(se::Values const& v, double const ageMs) {
+	std::printf("frame %llu  %.1f fps  interval p50/p95/p99 %.2f/%.2f/%.2f ms  cpu %.2f  gpu %.2f  fence %.2f/%.2f  acquire %.2f/%.2f  present %.2f/%.2f ms\n",
+				ull(v.frames), double(v.fps), double(v.intervalP50Ms), double(v.intervalP95Ms), double(v.intervalP99Ms), double(v.cpuP50Ms), double(v.gpuMs),
+				double(v.fenceWaitP50Ms), double(v.fenceWaitP95Ms), double(v.acquireP50Ms), double(v.acquireP95Ms), double(v.presentP50Ms),
+				double(v.presentP95Ms));
+	std::printf("  stutters %llu  swapchain recreations %llu  acquire timeouts %llu  events %llu (%u last poll)  memory %.1f MiB device, %.1f MiB host, "
+				"heaps %.1f / %.1f MiB  age %.0f ms\n",
+				ull(v.stutters), ull(v.swapchainRecreations), ull(v.acquireTimeouts), ull(v.events), v.eventsLastPoll, mib(v.deviceBytes), mib(v.hostBytes),
+				mib(v.heapUsage), mib(v.heapBudget), ageMs);
+	std::fflush(stdout);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::fprintf(stderr, "Usage: %s <shared memory name> [interval ms]\n", argv[0]);
+		return 1;
+	}
+	auto name = std::string(argv[1]);
+	if (name.front() != '/') { name.insert(name.begin(), '/'); }
+	auto const interval = std::chrono::milliseconds(argc > 2 ? std::atoi(argv[2]) : 1000);
+	auto const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		std::fprintf(stderr, "No segment named %s\n", name.c_str());
+		return 1;
+	}
+	auto* const mapped = ::mmap(nullptr, sizeof(se::Segment), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED) { return 1; }
+	auto const& segment = *static_cast<se::Segment const*>(mapped);
+	if (segment.magic != se::magic_v || segment.version != se::version_v || segment.size != sizeof(se::Segment)) {
+		std::fprintf(stderr, "%s: layout mismatch (version %u)\n", name.c_str(), segment.version);
+		return 1;
+	}
+	std::printf("Reading %s (pid %u)\n", name.c_str(), segment.pid);
+	// the segment outlives its writer while mapped here: stop once the process has gone
+	while (::kill(static_cast<pid_t>(segment.pid), 0) == 0) {
+		if (auto const values = se::read(segment)) {
+			auto const now = std::chrono::steady_clock::now().time_since_epoch();
+			auto const age = std::chrono::duration<double, std::milli>(now - std::chrono::nanoseconds(values->timeNs));
+			print(*values, age.count());
+		}
+		std::this_thread::sleep_for(interval);
+	}
+	std::printf("Process %u exited\n", segment.pid);
+	::munmap(mapped, sizeof(se::Segment));
+}
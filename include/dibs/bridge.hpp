@@ -3,10 +3,16 @@
 
 #include <GLFW/glfw3.h>
 #include <dibs/dibs.hpp>
+#include <dibs/stats.hpp>
+#include <ktl/enum_flags/enum_flags.hpp>
 
 namespace dibs {
+using VKFeature = GpuFeature;
+using VKFeatures = GpuFeatures;
+
 struct VKGpu {
 	vk::PhysicalDeviceProperties properties;
+	vk::PhysicalDeviceMemoryProperties memory;
 	std::vector<vk::SurfaceFormatKHR> formats;
 	vk::PhysicalDevice device;
 };
@@ -21,12 +27,100 @@ struct VKDevice {
 	vk::Instance instance;
 	vk::Device device;
 	VKQueue queue;
+	VKQueue compute; // dedicated / separate family if available (VKFeature::eAsyncCompute), else queue
+	VKFeatures features;				 // enabled
+	std::vector<std::string> extensions; // enabled
+};
+
+// frames recorded / executing concurrently; resources written by async compute each frame should be duplicated per frame slot
+constexpr std::size_t frames_in_flight_v = 2U;
+
+// resource written by async compute and read by graphics in the same frame; set either buffer or image
+// layout is unchanged by the transfer; image contents are not preserved when compute next writes it (transition from undefined)
+struct VKComputeRelease {
+	vk::Buffer buffer;
+	vk::Image image;
+	vk::ImageSubresourceRange range{vk::ImageAspectFlagBits::eColor, 0U, 1U, 0U, 1U};
+	vk::ImageLayout layout{vk::ImageLayout::eGeneral};
+	vk::PipelineStageFlags dstStage{vk::PipelineStageFlagBits::eFragmentShader};
+	vk::AccessFlags dstAccess{vk::AccessFlagBits::eShaderRead};
 };
 
+// semaphore a VKSubmit waits on before stages execute
+struct VKWait {
+	vk::Semaphore semaphore;
+	vk::PipelineStageFlags stages{vk::PipelineStageFlagBits::eAllCommands};
+};
+
+// command buffers for VKDevice::queue, submitted in one batch of the frame's queue submission
+struct VKSubmit {
+	std::span<vk::CommandBuffer const> commandBuffers;
+	std::span<VKWait const> waits;
+	std::span<vk::Semaphore const> signals; // binary
+	bool afterFrame{};						 // else before the frame's own commands
+};
+
+struct VKPipelineDesc;
+struct VKComputeDesc;
+class VKPipeline;
+
+// suballocation of the current frame's ring buffer: persistently mapped and host-coherent, valid until the frame's commands have executed
+struct VKFrameAlloc {
+	vk::Buffer buffer;
+	vk::DeviceSize offset{}; // aligned: bind / dynamic offset into buffer
+	vk::DeviceSize size{};
+	std::byte* data{};
+
+	explicit operator bool() const noexcept { return static_cast<bool>(buffer); }
+};
+
+// heap index, its budget, and whether usage rose above (or fell back below) the watched fraction
+using VKMemoryCallback = ktl::kfunction<void(std::uint32_t, HeapBudget const&, bool)>;
+
 class Bridge {
   public:
 	static VKDevice const& vulkan(Instance const& instance) noexcept;
 	static GLFWwindow* glfw(Instance const& instance) noexcept;
+	// device-level entry points are loaded with vkGetDeviceProcAddr (no loader trampoline); dibs and its Dear ImGui backend call through this
+	static vk::DispatchLoaderDynamic const& dispatch(Instance const& instance) noexcept;
+	// recording; commands are submitted before frame graph passes
 	static vk::CommandBuffer drawCmd(Frame const& frame) noexcept;
+	// null if dynamic rendering is in use
+	static vk::RenderPass renderPass(Instance const& instance) noexcept;
+	static vk::Format colourFormat(Instance const& instance) noexcept;
+	// GPU-timed region of commands recorded in drawCmd / frame graph passes, reported in Stats::gpu; label must outlive the stats (literal)
+	static void beginRegion(Frame const& frame, char const* label) noexcept;
+	static void endRegion(Frame const& frame) noexcept;
+	// secondary command buffer of the calling thread (a job worker, or the frame's thread), begun on first call;
+	// executed after drawCmd commands, once JobPhase::eRecord jobs have completed. Call from those jobs only.
+	// Executed outside any render pass and before the frame graph records its passes: no render pass is inherited, and the backbuffer
+	// is not yet in an attachment layout, so it cannot be drawn to. Transfers, dispatches and barriers are fine; draws must be
+	// wrapped in the buffer's own beginRendering / endRendering into other images, which requires VKFeature::eDynamicRendering
+	static vk::CommandBuffer workerCmd(Frame const& frame) noexcept;
+	// transient uniform / storage / vertex / index / indirect data for this frame (Stats::ring); thread safe, empty if out of memory.
+	// The offset is a multiple of both alignment (any, eg a vertex stride) and minUniformBufferOffsetAlignment
+	static VKFrameAlloc frameAlloc(Frame const& frame, vk::DeviceSize size, vk::DeviceSize alignment = 0U) noexcept;
+	// allocates and copies bytes
+	static VKFrameAlloc frameAlloc(Frame const& frame, std::span<std::byte const> bytes, vk::DeviceSize alignment = 0U) noexcept;
+	// requires dibs/pipelines.hpp
+	// returns immediately: compiled on a job worker (shader modules cached by SPIR-V hash), or shared with an identical request
+	static VKPipeline pipeline(Instance const& instance, VKPipelineDesc const& desc);
+	static VKPipeline pipeline(Instance const& instance, VKComputeDesc const& desc);
+	// per memory heap, refreshed on each Frame construction (Stats::memory)
+	static std::span<HeapBudget const> memoryBudget(Instance const& instance) noexcept;
+	// callback is invoked while constructing a Frame when a heap's usage crosses fraction of its budget: shed caches before the driver pages
+	static void onMemoryBudget(Instance const& instance, float fraction, VKMemoryCallback callback);
+	// thread safe; spans are copied. Batches execute in the order they were added, before (or after) the frame's commands,
+	// in a single vkQueueSubmit2 (vkQueueSubmit without synchronization2) when the Frame is destroyed, even if it is not ready.
+	// Command buffers must remain valid until the frame completes (Instance::gpuComplete)
+	static void submit(Frame const& frame, VKSubmit const& submit);
+	// [0, frames_in_flight_v)
+	static std::size_t frameSlot(Frame const& frame) noexcept;
+	// recording on VKDevice::compute; begun on first call. Null after submitCompute in the same frame
+	static vk::CommandBuffer computeCmd(Frame const& frame) noexcept;
+	// submit recorded compute commands now (else they are submitted before graphics when the Frame is destroyed);
+	// graphics waits for (and acquires ownership of) releases only, at their dstStage.
+	// Once per frame: a second call returns Error::eInvalidArg (nothing is submitted), else the vkQueueSubmit result
+	static Result<vk::Result> submitCompute(Frame const& frame, std::span<VKComputeRelease const> releases = {}) noexcept;
 };
 } // namespace dibs
@@ -2,13 +2,65 @@
 #include <dibs/error.hpp>
 #include <dibs/event.hpp>
 #include <dibs/rgba.hpp>
+#include <ktl/async/kfunction.hpp>
 #include <ktl/enum_flags/enum_flags.hpp>
 #include <chrono>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <span>
+#include <string>
+#include <vector>
 
 namespace dibs {
+class FrameGraph;
+class Frame;
+struct Stats;
+class Task;
+class NextFrame;
+class GpuComplete;
+class Background;
+class Jobs;
+
+// dynamic rendering, synchronization2, pipeline statistics and async compute are enabled whenever available
+enum class GpuFeature {
+	eDynamicRendering,
+	eSynchronization2,
+	ePipelineStatistics,
+	eAsyncCompute, // compute queue family separate from graphics
+	eDescriptorIndexing,
+	eTimelineSemaphore,
+	eBufferDeviceAddress,
+	eSamplerAnisotropy,
+	eFillModeNonSolid,
+	eWideLines,
+};
+using GpuFeatures = ktl::enum_flags<GpuFeature, std::uint32_t>;
+
+// render FrameGraph::scene() at a fraction of the frame extent, picked from recent GPU frame times
+struct DynamicResolution {
+	float budgetMs{}; // GPU frame time target; disabled if zero
+	float minScale{0.5f};
+	float maxScale{1.0f};
+};
+
+// worker threads of Instance::jobs()
+struct JobConfig {
+	std::uint32_t workers{}; // hardware threads - 1 if zero
+	bool pinCores{};		 // pin each worker to a core (leaving the first for the calling thread), where supported
+};
+
+// share each presented frame with another process over a Unix socket (Linux only); protocol: dibs/frame_export.hpp
+struct ExportConfig {
+	std::string socket;		  // path to listen on; disabled if empty, or if another process is listening there
+	std::uint32_t images{3U}; // shared images (up to frame_export::max_images_v): frames are dropped while the consumer holds all
+};
+
+// draws Dear ImGui: dibs' renderer (geometry in the frame ring, merged draws), or the stock Vulkan backend (default).
+// eNative binds texture ids through its own set layout (binding 0: combined image sampler, fragment stage): textures added
+// with ImGui_ImplVulkan_AddTexture are only valid if the backend's layout is identical (no immutable samplers)
+enum class UiRenderer { eNative, eBackend };
+
 struct Poll {
 	std::span<Event const> events;
 	std::chrono::duration<float> dt{};
@@ -40,7 +92,41 @@ class Instance {
 	void sizeLimits(std::optional<uvec2> min, std::optional<uvec2> max) noexcept;
 	void aspectRatio(float ratio) noexcept;
 	void title(std::string_view utf8) noexcept;
+	// RGBA8 bitmaps; a single bitmap is box-downscaled into smaller sizes (down to 16x16)
 	void icon(std::span<Bitmap const> bitmaps) noexcept;
+	// cap the frame rate: poll() waits for evenly spaced deadlines before sampling input;
+	// 0 paces to the refresh rate of the window's monitor, nullopt disables. Accuracy: Stats::pacing
+	void pace(std::optional<float> fps) noexcept;
+	// requires the swapchain to support transfer dst, and its format blit src / dst (else render scale stays 1); upscales with a
+	// linear filter where the format supports it, else nearest
+	void dynamicResolution(DynamicResolution const& config) noexcept;
+	// call outside a Frame
+	void uiRenderer(UiRenderer renderer);
+	// call outside a Frame. Replaces the window, its surface and swapchain, keeping the device, pipelines, jobs, tasks,
+	// Dear ImGui (context, fonts, textures) and everything uploaded; size limits, aspect ratio and icon are applied to the new window.
+	// Returns the new framebuffer size.
+	// The current window is kept if the new window, its surface or Dear ImGui's Vulkan backend cannot be created. If only the
+	// swapchain fails, the new window is kept and Frames are unready until a later attempt succeeds (eVulkanInitFailure either way)
+	Result<uvec2> recreateWindow(std::string_view title, uvec2 extent, Flags flags = {});
+	UiRenderer uiRenderer() const noexcept;
+
+	// Frame that waits at most timeout (zero: polls) for a swapchain image, else is unready (counted in Stats::acquire).
+	// Still waits for the GPU to finish with the frame's resources, as Frame does
+	[[nodiscard]] Frame tryFrame(std::chrono::nanoseconds timeout, RGBA clear = {0x22, 0x22, 0x22}) const;
+
+	// requires dibs/stats.hpp
+	Stats const& stats() const noexcept;
+
+	// requires dibs/task.hpp
+	// start a coroutine owned by this instance: destroyed when it completes or with the instance
+	void spawn(Task task);
+	NextFrame nextFrame() const noexcept;
+	// frame: Frame::id()
+	GpuComplete gpuComplete(std::uint64_t frame) const noexcept;
+	Background background(ktl::kfunction<void()> work) const noexcept;
+
+	// requires dibs/jobs.hpp
+	Jobs jobs() const noexcept;
 
   private:
 	struct Impl;
@@ -57,11 +143,26 @@ class Frame {
 
 	bool ready() const noexcept;
 	uvec2 extent() const noexcept;
+	// extent of FrameGraph::scene(), and its ratio to extent() (1 without dynamic resolution)
+	uvec2 renderExtent() const noexcept;
+	float renderScale() const noexcept;
+	float budgetMs() const noexcept;
+	// sequence number (also for frames that did not draw), for Instance::gpuComplete
+	std::uint64_t id() const noexcept { return m_id; }
+	// requires dibs/frame_graph.hpp
+	FrameGraph graph() const noexcept;
+	// CPU scratch for this frame (Stats::arena): thread safe, frees nothing until the frame's fence has signalled
+	// (frames_in_flight_v frames later), when all of it is released at once
+	std::pmr::memory_resource& arena() const noexcept;
 
   private:
+	Frame(Instance const& instance, RGBA clear, std::uint64_t timeoutNs);
+
 	RGBA m_clear;
 	Instance const& m_instance;
+	std::uint64_t m_id{};
 	friend class Bridge;
+	friend class Instance;
 };
 
 class Instance::Builder {
@@ -69,6 +170,29 @@ class Instance::Builder {
 	Builder& extent(uvec2 v) noexcept { return (m_extent = v, *this); }
 	Builder& title(std::string s) noexcept { return (m_title = std::move(s), *this); }
 	Builder& flags(Flags f) noexcept { return (m_flags = f, *this); }
+	// present intervals (ms) counted by FrameStats::overBudget (up to FrameStats::max_budgets_v)
+	Builder& frameBudgets(std::vector<float> ms) noexcept { return (m_frameBudgets = std::move(ms), *this); }
+	// adapters lacking required features / extensions are skipped (Error::eNoSuitableGpu if none remain);
+	// the rest are scored on type, memory, queue families, limits and desired support. Enabled set: Bridge::vulkan()
+	Builder& requireFeatures(GpuFeatures f) noexcept { return (m_required |= f, *this); }
+	Builder& desireFeatures(GpuFeatures f) noexcept { return (m_desired |= f, *this); }
+	Builder& requireExtension(std::string name) { return (m_requiredExtensions.push_back(std::move(name)), *this); }
+	Builder& desireExtension(std::string name) { return (m_desiredExtensions.push_back(std::move(name)), *this); }
+	// select a suitable adapter by name (case-insensitive substring) or UUID (hex, as logged); DIBS_GPU in the environment takes precedence
+	Builder& gpu(std::string nameOrUuid) noexcept { return (m_gpu = std::move(nameOrUuid), *this); }
+	// Instance::pace
+	Builder& pace(std::optional<float> fps) noexcept { return (m_pace = fps, *this); }
+	// Instance::dynamicResolution
+	Builder& dynamicResolution(DynamicResolution const& config) noexcept { return (m_dynamicResolution = config, *this); }
+	// Instance::jobs
+	Builder& jobs(JobConfig const& config) noexcept { return (m_jobs = config, *this); }
+	// Instance::uiRenderer
+	Builder& uiRenderer(UiRenderer renderer) noexcept { return (m_uiRenderer = renderer, *this); }
+	// zero-copy when the GPU supports VK_KHR_external_memory_fd and VK_KHR_external_semaphore_fd (desired when set)
+	Builder& exportFrames(ExportConfig config) noexcept { return (m_export = std::move(config), *this); }
+	// publish frame stats to a POSIX shared memory segment (layout: dibs/stats_export.hpp); DIBS_STATS_SHM in the environment takes precedence.
+	// A segment left by an exited process is replaced; export is disabled (with a warning) if a running process owns the name
+	Builder& exportStats(std::string shmName) noexcept { return (m_statsShm = std::move(shmName), *this); }
 
 	Result<Instance> operator()() const;
 
@@ -76,5 +200,17 @@ class Instance::Builder {
 	std::string m_title{"Untitled"};
 	uvec2 m_extent{1280U, 720U};
 	Flags m_flags;
+	std::vector<float> m_frameBudgets{16.6f, 33.3f};
+	GpuFeatures m_required;
+	GpuFeatures m_desired;
+	std::vector<std::string> m_requiredExtensions;
+	std::vector<std::string> m_desiredExtensions;
+	std::string m_gpu;
+	std::optional<float> m_pace;
+	DynamicResolution m_dynamicResolution;
+	JobConfig m_jobs;
+	UiRenderer m_uiRenderer{UiRenderer::eBackend};
+	ExportConfig m_export;
+	std::string m_statsShm;
 };
 } // namespace dibs
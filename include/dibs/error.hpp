@@ -10,6 +10,7 @@ enum class Error {
 	eWindowCreationFailure,
 	ImGuiInitFailure,
 	eInvalidArg,
+	eNoSuitableGpu,
 };
 
 template <typename T>
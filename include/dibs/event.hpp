@@ -60,7 +60,8 @@ class Event {
 	Key const& key() const noexcept { return (check(Type::eKey), m_payload.key); }
 	Button const& mouseButton() const noexcept { return (check(Type::eMouseButton), m_payload.button); }
 	std::uint32_t codepoint() const noexcept { return (check(Type::eText), m_payload.u32); }
-	std::span<std::string const> fileDrop() const noexcept;
+	// valid until the next poll(); allocated from the frame arena (std::pmr::string, not std::string)
+	std::span<std::pmr::string const> fileDrop() const noexcept;
 
   private:
 	void check([[maybe_unused]] Type const type) const noexcept { assert(m_type == type); }
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// wire protocol of Builder::exportFrames, for consumers: messages on a SOCK_SEQPACKET Unix socket, dibs listening
+namespace dibs::frame_export {
+inline constexpr std::uint32_t magic_v = 0x53424944U; // "DIBS"
+inline constexpr std::uint32_t version_v = 2U;
+inline constexpr std::uint32_t max_images_v = 8U;
+
+enum class Mode : std::uint32_t {
+	eExternalMemory, // VkDeviceMemory and binary VkSemaphores as opaque fds: no copies on the CPU
+	eSharedMemory,	 // one shared memory fd holding count tightly packed images (readbacks)
+};
+
+enum class Type : std::uint32_t { eConfig, eFrame, eRelease };
+
+// dibs -> consumer, on connection and again whenever the images are recreated (generation changes).
+// File descriptors follow as SCM_RIGHTS: eExternalMemory: count memory fds, then count semaphore fds; eSharedMemory: one fd of count * size bytes
+struct Config {
+	Type type{Type::eConfig};
+	std::uint32_t magic{magic_v};
+	std::uint32_t version{version_v};
+	Mode mode{};
+	std::uint32_t generation{};
+	std::uint32_t count{};
+	std::uint32_t width{};
+	std::uint32_t height{};
+	std::uint32_t format{};		// VkFormat of the swapchain (eSharedMemory: texels as in that format, rows of width * texel bytes: 4, or 8 / 16 for wide formats)
+	std::uint32_t usage{};		// VkImageUsageFlags: create an identical 2D, optimal tiling, single mip / layer image to bind each memory fd to
+	std::uint32_t memoryType{}; // eExternalMemory: memoryTypeIndex of the exported allocations; import with it and size
+	std::uint32_t dedicated{};	// eExternalMemory: non-zero if each allocation is dedicated to its image (import with VkMemoryDedicatedAllocateInfo)
+	std::uint64_t size{};		// bytes per memory allocation / shared memory image
+	std::uint8_t deviceUuid[16]{};
+	std::uint8_t driverUuid[16]{}; // eExternalMemory: import on the physical device with these
+};
+
+// dibs -> consumer: image index holds frame. eExternalMemory: wait on its semaphore before reading; the image is in
+// VK_IMAGE_LAYOUT_GENERAL, released to VK_QUEUE_FAMILY_EXTERNAL (acquire it from there)
+struct Frame {
+	Type type{Type::eFrame};
+	std::uint32_t generation{};
+	std::uint32_t index{};
+	std::uint64_t frame{}; // Frame::id
+};
+
+// consumer -> dibs: finished with index (eExternalMemory: its semaphore wait has been submitted and reads have completed)
+struct Release {
+	Type type{Type::eRelease};
+	std::uint32_t generation{};
+	std::uint32_t index{};
+};
+
+// largest message: receive into a buffer of this size, then copy out by type (the first member of each)
+inline constexpr std::size_t max_message_v = sizeof(Config);
+} // namespace dibs::frame_export
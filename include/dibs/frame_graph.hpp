@@ -0,0 +1,71 @@
+#pragma once
+#include <dibs/bridge.hpp>
+#include <ktl/async/kfunction.hpp>
+#include <initializer_list>
+#include <span>
+#include <string>
+
+namespace dibs {
+namespace detail {
+class RenderGraph;
+}
+
+// Per-frame graph of passes: barriers, pass order and transient attachment memory are derived from declared accesses.
+// Passes are recorded when the Frame is destroyed (after any Bridge::drawCmd commands), followed by the Dear ImGui pass.
+class FrameGraph {
+  public:
+	enum class Use : std::uint8_t { eColourAttachment, eDepthAttachment, eSampled, eStorageRead, eStorageWrite, eTransferSrc, eTransferDst };
+
+	struct Image {
+		std::uint32_t index{};
+
+		bool operator==(Image const&) const = default;
+	};
+
+	struct Access {
+		Image image;
+		Use use{};
+	};
+
+	// contents are undefined at the start of each frame, memory may be aliased with transients whose lifetimes do not overlap
+	struct Transient {
+		vk::Format format{};
+		uvec2 extent{}; // frame extent if zero
+	};
+
+	class Context;
+	using Record = ktl::kfunction<void(Context const&)>;
+
+	Image backbuffer() const noexcept { return {}; }
+	// with dynamic resolution enabled: a backbuffer-format target whose Context::extent() is the render extent (Frame::renderExtent),
+	// upscaled into the backbuffer before the Dear ImGui pass; otherwise the backbuffer
+	Image scene();
+	Image transient(Transient const& desc);
+	// not recorded if a transient it accesses could not be allocated (out of device memory)
+	FrameGraph& pass(std::string name, std::span<Access const> accesses, Record record);
+	FrameGraph& pass(std::string name, std::initializer_list<Access> accesses, Record record) {
+		return pass(std::move(name), std::span<Access const>(accesses.begin(), accesses.size()), std::move(record));
+	}
+
+  private:
+	FrameGraph(detail::RenderGraph& graph) noexcept : m_graph(&graph) {}
+
+	detail::RenderGraph* m_graph;
+	friend class Frame;
+};
+
+class FrameGraph::Context {
+  public:
+	vk::CommandBuffer cb() const noexcept { return m_cb; }
+	vk::Image image(Image image) const noexcept;
+	vk::ImageView view(Image image) const noexcept;
+	vk::Extent2D extent(Image image) const noexcept;
+
+  private:
+	Context(detail::RenderGraph const& graph, vk::CommandBuffer cb) noexcept : m_graph(&graph), m_cb(cb) {}
+
+	detail::RenderGraph const* m_graph;
+	vk::CommandBuffer m_cb;
+	friend class detail::RenderGraph;
+};
+} // namespace dibs
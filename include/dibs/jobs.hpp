@@ -0,0 +1,55 @@
+#pragma once
+#include <dibs/dibs.hpp>
+#include <ktl/async/kfunction.hpp>
+#include <memory>
+
+namespace dibs {
+namespace detail {
+class JobSystem;
+struct JobState;
+} // namespace detail
+
+// when a job must have completed (with all its children)
+enum class JobPhase : std::uint8_t {
+	eRecord, // before the current Frame records its passes (jobs may record Bridge::workerCmd)
+	eSubmit, // before the current Frame submits
+	eAsync,	 // no frame dependency: may span frames (asset decoding, etc)
+};
+
+// completion of a job and every job pushed from within it (its children)
+class JobHandle {
+  public:
+	JobHandle() = default;
+
+	// true if empty
+	bool done() const noexcept;
+
+  private:
+	JobHandle(std::shared_ptr<detail::JobState> state) noexcept : m_state(std::move(state)) {}
+
+	std::shared_ptr<detail::JobState> m_state;
+	friend class Jobs;
+};
+
+// Work-stealing thread pool owned by an Instance (Builder::jobs): one deque per worker; idle workers steal from the others.
+// Per-worker utilization is reported in Stats::workers.
+class Jobs {
+  public:
+	using Work = ktl::kfunction<void()>;
+
+	// pushed from a job: the new job is a child of it
+	JobHandle push(Work work, JobPhase phase = JobPhase::eAsync);
+	// runs queued jobs on the calling thread until handle is done
+	void wait(JobHandle const& handle);
+
+	std::size_t workers() const noexcept;
+	// index of the calling worker thread in [0, workers()), workers() on any other thread
+	std::size_t thread() const noexcept;
+
+  private:
+	Jobs(detail::JobSystem& system) noexcept : m_system(&system) {}
+
+	detail::JobSystem* m_system;
+	friend class Instance;
+};
+} // namespace dibs
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace dibs {
+enum class LogLevel : std::uint8_t { eDebug, eInfo, eWarning, eError };
+
+// dibs queues log lines without blocking; sinks are invoked on a dedicated logging thread
+class LogSink {
+  public:
+	virtual ~LogSink() = default;
+
+	virtual void write(LogLevel level, std::string_view line) = 0;
+	virtual void flush() {}
+};
+
+std::unique_ptr<LogSink> makeStdoutSink();
+// returns null if path cannot be opened for writing
+std::unique_ptr<LogSink> makeFileSink(char const* path);
+
+// replace active sink (stdout by default); null restores the default
+void logSink(std::unique_ptr<LogSink> sink);
+// block until all queued lines have been written; returns immediately when called from a sink
+void logFlush();
+// number of lines discarded because the queue was full
+std::uint64_t logDropped() noexcept;
+// number of lines cut short (beyond ~8 KiB; marked " [truncated]")
+std::uint64_t logTruncated() noexcept;
+} // namespace dibs
@@ -0,0 +1,60 @@
+#pragma once
+#include <dibs/bridge.hpp>
+#include <memory>
+#include <vector>
+
+namespace dibs {
+namespace detail {
+class PipelineService;
+struct PipelineEntry;
+} // namespace detail
+
+// graphics pipeline state; identical descriptions (by content) share one pipeline. Viewport and scissor are dynamic
+struct VKPipelineDesc {
+	std::vector<std::uint32_t> vertex;	 // SPIR-V
+	std::vector<std::uint32_t> fragment; // SPIR-V
+	vk::PipelineLayout layout;
+	std::vector<vk::VertexInputBindingDescription> bindings;
+	std::vector<vk::VertexInputAttributeDescription> attributes;
+	vk::PrimitiveTopology topology{vk::PrimitiveTopology::eTriangleList};
+	vk::PolygonMode polygonMode{vk::PolygonMode::eFill};
+	vk::CullModeFlags cullMode{vk::CullModeFlagBits::eNone};
+	vk::FrontFace frontFace{vk::FrontFace::eCounterClockwise};
+	float lineWidth{1.0f};
+	bool depthTest{};
+	bool depthWrite{};
+	vk::CompareOp depthCompare{vk::CompareOp::eLessOrEqual};
+	bool alphaBlend{true};
+	// subpass 0 of renderPass if set, else dynamic rendering into these formats (colour: Bridge::colourFormat if undefined)
+	vk::RenderPass renderPass;
+	vk::Format colour{};
+	vk::Format depth{};
+
+	bool operator==(VKPipelineDesc const&) const = default;
+};
+
+struct VKComputeDesc {
+	std::vector<std::uint32_t> shader; // SPIR-V
+	vk::PipelineLayout layout;
+
+	bool operator==(VKComputeDesc const&) const = default;
+};
+
+// compiled on a job worker: draw a fallback or skip the draw until ready
+class VKPipeline {
+  public:
+	VKPipeline() = default;
+
+	// null until ready; a use while still compiling is counted in Stats::pipelines
+	vk::Pipeline get() const noexcept;
+	bool ready() const noexcept;
+	bool failed() const noexcept;
+	explicit operator bool() const noexcept { return ready(); }
+
+  private:
+	VKPipeline(std::shared_ptr<detail::PipelineEntry> entry) noexcept : m_entry(std::move(entry)) {}
+
+	std::shared_ptr<detail::PipelineEntry> m_entry;
+	friend class detail::PipelineService;
+};
+} // namespace dibs
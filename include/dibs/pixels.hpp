@@ -0,0 +1,41 @@
+#pragma once
+#include <dibs/dibs.hpp>
+#include <cstdint>
+#include <span>
+
+// Batch pixel conversions (8-bit RGBA unless noted), vectorized with the best instruction set available at runtime.
+// Unless noted, src and dst may alias exactly, and dst must be at least as large as src.
+
+namespace dibs {
+enum class SimdLevel : std::uint8_t { eScalar, eSse2, eAvx2, eNeon };
+
+namespace pixels {
+// instruction set in use
+SimdLevel simd() noexcept;
+// use max, or the closest supported level below it (levels of other architectures: scalar); returns the level now in use
+SimdLevel simd(SimdLevel max) noexcept;
+constexpr char const* simdName(SimdLevel const level) noexcept {
+	switch (level) {
+	case SimdLevel::eScalar: return "scalar";
+	case SimdLevel::eSse2: return "sse2";
+	case SimdLevel::eAvx2: return "avx2";
+	case SimdLevel::eNeon: return "neon";
+	}
+	return "unknown";
+}
+
+// RGBA <=> BGRA
+void swizzle(std::span<std::uint8_t const> src, std::span<std::uint8_t> dst) noexcept;
+// clamps to [0, 1], rounds to nearest; any channel count
+void pack(std::span<float const> src, std::span<std::uint8_t> dst) noexcept;
+// RGB through an sRGB decode table, alpha scaled linearly; dst: 4 floats per pixel (must not alias)
+void srgbToLinear(std::span<std::uint8_t const> src, std::span<float> dst) noexcept;
+// RGB *= A (exactly rounded)
+void premultiply(std::span<std::uint8_t const> src, std::span<std::uint8_t> dst) noexcept;
+
+// each dimension halved (rounding down, at least 1)
+constexpr uvec2 halved(uvec2 const extent) noexcept { return {extent.x > 1U ? extent.x / 2U : 1U, extent.y > 1U ? extent.y / 2U : 1U}; }
+// 2x2 box filter into halved(src.extent) pixels (must not alias)
+void downscale(Bitmap const& src, std::span<std::uint8_t> dst) noexcept;
+} // namespace pixels
+} // namespace dibs
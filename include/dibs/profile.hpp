@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+// Scoped CPU zones recorded into per-thread buffers and exported as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+// Zones compile to nothing unless dibs is built with DIBS_PROFILE.
+
+namespace dibs::profile {
+#if defined(DIBS_PROFILE)
+constexpr bool enabled_v = true;
+#else
+constexpr bool enabled_v = false;
+#endif
+
+// names must outlive export (string literals); a no-op without DIBS_PROFILE
+class Zone {
+  public:
+#if defined(DIBS_PROFILE)
+	explicit Zone(char const* name) noexcept;
+	~Zone() noexcept;
+#else
+	explicit Zone(char const*) noexcept {}
+#endif
+
+	Zone(Zone const&) = delete;
+	Zone& operator=(Zone const&) = delete;
+
+#if defined(DIBS_PROFILE)
+  private:
+	char const* m_name;
+	std::int64_t m_start;
+#endif
+};
+
+// name the calling thread in exported traces
+void threadName(char const* name) noexcept;
+// write all recorded zones to path; returns false if profiling is disabled or the file could not be written.
+// Safe while other threads record: the oldest zones of a full buffer may be dropped if they are overwritten during export
+bool exportTrace(char const* path);
+// export to path when the process exits
+void exportTraceOnExit(char const* path);
+} // namespace dibs::profile
+
+#define DIBS_ZONE_CAT_(a, b) a##b
+#define DIBS_ZONE_CAT(a, b) DIBS_ZONE_CAT_(a, b)
+
+#if defined(DIBS_PROFILE)
+#define DIBS_ZONE(name) ::dibs::profile::Zone const DIBS_ZONE_CAT(dibs_zone_, __LINE__)(name)
+#else
+#define DIBS_ZONE(name) static_cast<void>(0)
+#endif
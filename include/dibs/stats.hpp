@@ -0,0 +1,262 @@
+#pragma once
+#include <ktl/fixed_vector.hpp>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace dibs {
+// fixed-capacity ring of the most recent samples; index 0 is the oldest
+template <typename T, std::size_t Capacity>
+class History {
+  public:
+	static constexpr std::size_t capacity_v = Capacity;
+
+	void push(T const& t) noexcept {
+		m_items[(m_start + m_size) % Capacity] = t;
+		if (m_size < Capacity) {
+			++m_size;
+		} else {
+			m_start = (m_start + 1U) % Capacity;
+		}
+	}
+
+	void clear() noexcept { m_start = m_size = 0U; }
+
+	std::size_t size() const noexcept { return m_size; }
+	bool empty() const noexcept { return m_size == 0U; }
+	T const& operator[](std::size_t index) const noexcept { return m_items[(m_start + index) % Capacity]; }
+	T const& latest() const noexcept { return (*this)[m_size - 1U]; }
+
+  private:
+	std::array<T, Capacity> m_items{};
+	std::size_t m_start{};
+	std::size_t m_size{};
+};
+
+struct PipelineStats {
+	std::uint64_t inputAssemblyVertices{};
+	std::uint64_t inputAssemblyPrimitives{};
+	std::uint64_t vertexShaderInvocations{};
+	std::uint64_t clippingInvocations{};
+	std::uint64_t clippingPrimitives{};
+	std::uint64_t fragmentShaderInvocations{};
+	std::uint64_t computeShaderInvocations{};
+};
+
+// GPU execution times of a completed frame, in milliseconds
+struct GpuFrame {
+	struct Region {
+		char const* label{};
+		float ms{};
+	};
+
+	std::uint64_t frame{};
+	float ms{};							   // entire frame
+	float passesMs{};					   // Bridge::drawCmd commands and frame graph passes
+	float imguiMs{};					   // Dear ImGui pass
+	ktl::fixed_vector<Region, 16> regions; // Bridge::beginRegion / endRegion, in recording order
+	std::optional<PipelineStats> pipeline; // if supported by the device
+};
+
+// CPU timings of a presented frame, in milliseconds
+struct FrameSample {
+	std::uint64_t frame{};
+	float intervalMs{};	 // present to present
+	float outsideMs{};	 // between Frames (poll and application work)
+	float cpuMs{};		 // inside Frame, excluding the waits below
+	float fenceWaitMs{}; // waiting for the GPU to release the frame's resources
+	float acquireMs{};	 // waiting for a swapchain image
+	float presentMs{};
+	float paceMs{}; // frame pacer wait in poll() (not included in outsideMs)
+};
+
+enum class Phase : std::uint8_t { eOutside, eCpu, eFenceWait, eAcquire, ePresent };
+
+constexpr char const* phaseName(Phase const phase) noexcept {
+	switch (phase) {
+	case Phase::eOutside: return "outside";
+	case Phase::eCpu: return "cpu";
+	case Phase::eFenceWait: return "fence_wait";
+	case Phase::eAcquire: return "acquire";
+	case Phase::ePresent: return "present";
+	}
+	return "unknown";
+}
+
+// a present interval well above the recent average; phase is the largest contributor to that frame
+struct Stutter {
+	std::uint64_t frame{};
+	float ms{};
+	float expectedMs{};
+	Phase phase{};
+};
+
+// fixed-size; never allocates
+class FrameStats {
+  public:
+	enum class Metric : std::uint8_t { eInterval, eOutside, eCpu, eFenceWait, eAcquire, ePresent, ePace };
+
+	static constexpr std::size_t max_budgets_v = 4U;
+	static constexpr std::size_t bins_v = 32U;
+	static constexpr float bin_ms_v = 2.0f; // last bin also counts everything above
+	static constexpr float stutter_factor_v = 2.0f;
+
+	using Histogram = std::array<std::uint32_t, bins_v>;
+
+	FrameStats() noexcept : FrameStats(std::array{16.6f, 33.3f}) {}
+	explicit FrameStats(std::span<float const> budgets) noexcept;
+
+	void record(FrameSample const& sample) noexcept;
+
+	History<FrameSample, 256> const& samples() const noexcept { return m_samples; }
+	History<Stutter, 32> const& stutters() const noexcept { return m_stutters; }
+	std::uint64_t frames() const noexcept { return m_frames; }
+	std::uint64_t stutterCount() const noexcept { return m_stutterCount; }
+
+	// over samples()
+	float mean(Metric metric) const noexcept;
+	float percentile(Metric metric, float p) const noexcept;
+	Histogram histogram(Metric metric) const noexcept;
+	float fps() const noexcept;
+
+	// present intervals over each budget since startup
+	std::span<float const> budgets() const noexcept { return std::span(m_budgets.data(), m_budgetCount); }
+	std::uint64_t overBudget(std::size_t index) const noexcept { return index < m_budgetCount ? m_overBudget[index] : 0U; }
+
+  private:
+	static float get(FrameSample const& sample, Metric metric) noexcept;
+
+	History<FrameSample, 256> m_samples;
+	History<Stutter, 32> m_stutters;
+	std::array<float, max_budgets_v> m_budgets{};
+	std::array<std::uint64_t, max_budgets_v> m_overBudget{};
+	std::size_t m_budgetCount{};
+	float m_average{};
+	std::uint64_t m_frames{};
+	std::uint64_t m_stutterCount{};
+};
+
+// frame pacer accuracy (Instance::pace)
+struct PacingStats {
+	float targetMs{};			   // zero if pacing is disabled
+	History<float, 256> lateMs;	   // wake-up past each deadline
+	History<float, 256> intervalMs; // wake to wake
+	std::uint64_t missed{};		   // deadlines already passed when the pacer was reached
+
+	// RMS deviation of intervals from the target
+	float jitterMs() const noexcept;
+	float maxLateMs() const noexcept;
+};
+
+// swapchain image acquisition (Frame, Instance::tryFrame)
+struct AcquireStats {
+	std::uint64_t acquired{};
+	std::uint64_t timeouts{}; // Instance::tryFrame returned an unready Frame: no image within the timeout
+	float lastWaitMs{};
+	float maxWaitMs{};
+	float meanWaitMs{};
+};
+
+// queue submissions (Bridge::submit batches share the frame's)
+struct SubmitStats {
+	std::uint32_t submits{}; // queue submit calls by the last Frame, including async compute
+	std::uint32_t batches{}; // graphics batches in them: the frame's and Bridge::submit's
+	std::uint64_t total{};	 // submit calls
+	bool sync2{};			 // vkQueueSubmit2
+};
+
+// Instance::jobs() worker threads (JobConfig::workers is clamped to this)
+constexpr std::size_t max_workers_v = 64U;
+
+struct WorkerStats {
+	float busy{};			// fraction of the time since the previous Frame spent running jobs
+	std::uint64_t jobs{};	// run (total)
+	std::uint64_t steals{}; // taken from other workers (total)
+};
+
+// Bridge::frameAlloc ring buffer
+struct FrameRingStats {
+	std::uint64_t capacity{};  // bytes, all frames in flight
+	std::uint64_t used{};	   // bytes allocated by the last completed frame (before any growth that frame)
+	std::uint64_t peak{};	   // largest used
+	std::uint64_t overflows{}; // times a frame's slot outgrew its buffer (and doubled it)
+};
+
+// Frame::arena CPU bump allocator
+struct FrameArenaStats {
+	std::uint64_t capacity{}; // bytes, all frames in flight
+	std::uint64_t used{};	  // bytes allocated by the last completed frame, including spills
+	std::uint64_t peak{};	  // largest used: size the arena to this
+	std::uint64_t spills{};	  // allocations that did not fit and went to the heap (total); the slot grows on reset
+};
+
+// Builder::exportFrames
+struct FrameExportStats {
+	bool listening{};
+	bool connected{};
+	bool external{};		  // frame_export::Mode::eExternalMemory: zero-copy
+	std::uint64_t exported{}; // frames published to the consumer (total)
+	std::uint64_t dropped{};  // frames not exported: every image still held by the consumer (total)
+	std::uint32_t generation{};
+};
+
+// Bridge::pipeline
+struct PipelineCompileStats {
+	std::uint64_t requested{};
+	std::uint64_t shared{}; // requests served by an identical existing / pending pipeline
+	std::uint64_t compiled{};
+	std::uint64_t failed{};
+	std::uint64_t pending{};
+	std::uint64_t shaderModules{};
+	std::uint64_t shaderHits{}; // modules reused by SPIR-V hash
+	std::uint64_t notReady{};	 // VKPipeline::get() calls while compiling (fallback / skipped draws)
+	std::uint64_t hitchFrames{}; // frames with at least one such call
+	float meanCompileMs{};
+	float maxCompileMs{};
+};
+
+// VK_MAX_MEMORY_HEAPS
+constexpr std::size_t max_heaps_v = 16U;
+
+// budget and usage of this process in a memory heap (VK_EXT_memory_budget), else the heap size and dibs' own allocations
+struct HeapBudget {
+	std::uint64_t budget{}; // bytes
+	std::uint64_t usage{};	// bytes
+	bool deviceLocal{};
+
+	float fraction() const noexcept { return budget > 0U ? static_cast<float>(double(usage) / double(budget)) : 0.0f; }
+};
+
+// memory held by a dibs subsystem
+struct Footprint {
+	char const* name{};
+	std::uint64_t device{}; // bytes
+	std::uint64_t host{};	// bytes
+	bool estimated{};		// derived from extents / formats / counts rather than allocation sizes
+};
+
+struct MemoryStats {
+	ktl::fixed_vector<HeapBudget, max_heaps_v> heaps;
+	ktl::fixed_vector<Footprint, 12> footprint;
+	bool budget{}; // VK_EXT_memory_budget is enabled: heap usage covers all allocations of this process
+};
+
+struct Stats {
+	// results are read back once a frame's fence has signalled, a couple of frames after submission
+	History<GpuFrame, 128> gpu;
+	FrameStats frames;
+	PacingStats pacing;
+	AcquireStats acquire;
+	SubmitStats submits;
+	ktl::fixed_vector<WorkerStats, max_workers_v> workers;
+	FrameRingStats ring;
+	FrameArenaStats arena;
+	FrameExportStats frameExport;
+	PipelineCompileStats pipelines;
+	MemoryStats memory; // refreshed on each Frame construction
+};
+
+// Dear ImGui window; call while a Frame is alive
+void showStats(Stats const& stats, bool* open = nullptr);
+} // namespace dibs
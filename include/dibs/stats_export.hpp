@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+
+// layout of Builder::exportStats, for monitors: one POSIX shared memory segment holding a Segment, rewritten at the end of every Frame
+namespace dibs::stats_export {
+inline constexpr std::uint32_t magic_v = 0x54534944U; // "DIST"
+inline constexpr std::uint32_t version_v = 1U;
+
+// one snapshot; durations in milliseconds, percentiles over the last FrameStats::samples()
+struct Values {
+	std::uint64_t frames{};				  // presented
+	std::uint64_t timeNs{};				  // steady_clock (CLOCK_MONOTONIC on Linux) at publication: stale once the process stops presenting
+	std::uint64_t stutters{};
+	std::uint64_t swapchainRecreations{};
+	std::uint64_t acquireTimeouts{};
+	std::uint64_t events{};				  // total
+	std::uint64_t deviceBytes{};		  // dibs' own footprint (Stats::memory)
+	std::uint64_t hostBytes{};
+	std::uint64_t heapUsage{};			  // all heaps
+	std::uint64_t heapBudget{};
+	float fps{};
+	float intervalP50Ms{};
+	float intervalP95Ms{};
+	float intervalP99Ms{};
+	float cpuP50Ms{};
+	float fenceWaitP50Ms{};
+	float fenceWaitP95Ms{};
+	float acquireP50Ms{};
+	float acquireP95Ms{};
+	float presentP50Ms{};
+	float presentP95Ms{};
+	float gpuMs{}; // latest read back
+	std::uint32_t eventsLastPoll{};
+	std::uint32_t reserved{};
+};
+
+struct Segment {
+	std::uint32_t magic{magic_v};
+	std::uint32_t version{version_v};
+	std::uint32_t size{}; // sizeof(Segment)
+	std::uint32_t pid{};
+	std::atomic<std::uint64_t> sequence{}; // seqlock: odd while values are being written
+	Values values;
+};
+
+static_assert(std::is_trivially_copyable_v<Values> && sizeof(Values) % 8U == 0U);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "sequence must be address-free to be shared between processes");
+
+// consistent copy of segment.values; nullopt if the writer was mid-update for every attempt (or died during one)
+inline std::optional<Values> read(Segment const& segment, int attempts = 64) noexcept {
+	for (; attempts > 0; --attempts) {
+		auto const before = segment.sequence.load(std::memory_order_acquire);
+		if (before & 1U) { continue; }
+		Values ret;
+		std::memcpy(&ret, &segment.values, sizeof(ret));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (segment.sequence.load(std::memory_order_relaxed) == before) { return ret; }
+	}
+	return std::nullopt;
+}
+} // namespace dibs::stats_export
@@ -0,0 +1,118 @@
+#pragma once
+#include <dibs/dibs.hpp>
+#include <ktl/async/kfunction.hpp>
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace dibs {
+namespace detail {
+class TaskScheduler;
+}
+
+// Coroutine driven by an Instance: lazy, started by Instance::spawn or by being awaited from another Task.
+// Suspended tasks are resumed on the thread calling poll() / constructing Frames, at the points documented by each awaitable.
+class Task {
+  public:
+	struct promise_type;
+	using Handle = std::coroutine_handle<promise_type>;
+
+	Task(Task&& rhs) noexcept : m_handle(std::exchange(rhs.m_handle, {})) {}
+	Task& operator=(Task rhs) noexcept { return (std::swap(m_handle, rhs.m_handle), *this); }
+	~Task() {
+		if (m_handle) { m_handle.destroy(); }
+	}
+
+	bool done() const noexcept { return !m_handle || m_handle.done(); }
+
+	// runs the task, resuming the awaiter when it completes
+	auto operator co_await() const noexcept { return Awaiter{m_handle}; }
+
+  private:
+	struct Final {
+		bool await_ready() const noexcept { return false; }
+		std::coroutine_handle<> await_suspend(Handle handle) const noexcept;
+		void await_resume() const noexcept {}
+	};
+
+	struct Awaiter {
+		Handle handle;
+
+		bool await_ready() const noexcept { return !handle || handle.done(); }
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept;
+		void await_resume() const noexcept {}
+	};
+
+	explicit Task(Handle handle) noexcept : m_handle(handle) {}
+
+	Handle m_handle;
+	friend class Instance;
+};
+
+struct Task::promise_type {
+	std::coroutine_handle<> continuation; // awaiting task, if any
+
+	Task get_return_object() noexcept { return Task(Handle::from_promise(*this)); }
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	Final final_suspend() const noexcept { return {}; }
+	void return_void() const noexcept {}
+	void unhandled_exception() const noexcept { std::terminate(); }
+};
+
+inline std::coroutine_handle<> Task::Final::await_suspend(Handle handle) const noexcept {
+	auto const continuation = handle.promise().continuation;
+	return continuation ? continuation : std::noop_coroutine();
+}
+
+inline std::coroutine_handle<> Task::Awaiter::await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+	handle.promise().continuation = awaiting;
+	return handle;
+}
+
+// resumes at the end of the next Frame's construction (commands recording, Dear ImGui frame open)
+class NextFrame {
+  public:
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> handle) const;
+	Frame const& await_resume() const noexcept;
+
+  private:
+	NextFrame(detail::TaskScheduler& scheduler) noexcept : m_scheduler(&scheduler) {}
+
+	detail::TaskScheduler* m_scheduler;
+	friend class Instance;
+};
+
+// resumes in the first poll() after the GPU has executed a frame's commands (immediately if it already has):
+// uploads / readbacks recorded into that frame are complete
+class GpuComplete {
+  public:
+	bool await_ready() const noexcept;
+	void await_suspend(std::coroutine_handle<> handle) const;
+	void await_resume() const noexcept {}
+
+  private:
+	GpuComplete(detail::TaskScheduler& scheduler, std::uint64_t frame) noexcept : m_scheduler(&scheduler), m_frame(frame) {}
+
+	detail::TaskScheduler* m_scheduler;
+	std::uint64_t m_frame;
+	friend class Instance;
+};
+
+// runs work on a job worker (JobPhase::eAsync), resumes in the first poll() after it returns
+class Background {
+  public:
+	using Work = ktl::kfunction<void()>;
+
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<> handle);
+	void await_resume() const noexcept {}
+
+  private:
+	Background(detail::TaskScheduler& scheduler, Work&& work) noexcept : m_scheduler(&scheduler), m_work(std::move(work)) {}
+
+	detail::TaskScheduler* m_scheduler;
+	Work m_work;
+	friend class Instance;
+};
+} // namespace dibs
@@ -1,6 +1,8 @@
 #include <detail/expect.hpp>
 #include <dibs/bridge.hpp>
+#include <dibs/pipelines.hpp>
 #include <instance_impl.hpp>
+#include <cstring>
 
 namespace dibs {
 VKDevice const& Bridge::vulkan(Instance const& instance) noexcept {
@@ -13,8 +15,98 @@ GLFWwindow* Bridge::glfw(Instance const& instance) noexcept {
 	return instance.m_impl->glfw.window;
 }
 
+vk::DispatchLoaderDynamic const& Bridge::dispatch(Instance const& instance) noexcept {
+	EXPECT(instance.m_impl);
+	return VULKAN_HPP_DEFAULT_DISPATCHER;
+}
+
 vk::CommandBuffer Bridge::drawCmd(Frame const& frame) noexcept {
 	EXPECT(frame.m_instance.m_impl->acquired);
 	return frame.m_instance.m_impl->frameSync.get().cb;
 }
+
+vk::RenderPass Bridge::renderPass(Instance const& instance) noexcept {
+	EXPECT(instance.m_impl);
+	return *instance.m_impl->renderPass;
+}
+
+vk::Format Bridge::colourFormat(Instance const& instance) noexcept {
+	EXPECT(instance.m_impl);
+	return instance.m_impl->surface.info.imageFormat;
+}
+
+void Bridge::beginRegion(Frame const& frame, char const* label) noexcept {
+	auto& sync = frame.m_instance.m_impl->frameSync.get();
+	sync.queries.beginRegion(sync.cb, label);
+}
+
+std::size_t Bridge::frameSlot(Frame const& frame) noexcept { return frame.m_instance.m_impl->frameSync.index; }
+
+vk::CommandBuffer Bridge::computeCmd(Frame const& frame) noexcept { return frame.m_instance.m_impl->frameSync.get().compute.cmd(); }
+
+vk::CommandBuffer Bridge::workerCmd(Frame const& frame) noexcept {
+	auto impl = frame.m_instance.m_impl.get();
+	auto& sync = impl->frameSync.get();
+	auto& cmd = sync.workers[impl->jobs.thread()];
+	if (!cmd.recording) {
+		// no render pass inheritance: secondaries are executed outside the dibs render pass, and may only draw via dynamic rendering
+		vk::CommandBufferInheritanceInfo inheritance;
+		inheritance.pipelineStatistics = sync.queries.inheritedStatistics();
+		cmd.cb.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit, &inheritance));
+		cmd.recording = true;
+	}
+	return cmd.cb;
+}
+
+VKFrameAlloc Bridge::frameAlloc(Frame const& frame, vk::DeviceSize const size, vk::DeviceSize const alignment) noexcept {
+	auto impl = frame.m_instance.m_impl.get();
+	return impl->ring.allocate(impl->frameSync.index, size, alignment);
+}
+
+VKFrameAlloc Bridge::frameAlloc(Frame const& frame, std::span<std::byte const> const bytes, vk::DeviceSize const alignment) noexcept {
+	auto ret = frameAlloc(frame, bytes.size(), alignment);
+	if (ret) { std::memcpy(ret.data, bytes.data(), bytes.size()); }
+	return ret;
+}
+
+VKPipeline Bridge::pipeline(Instance const& instance, VKPipelineDesc const& desc) {
+	EXPECT(instance.m_impl);
+	auto impl = instance.m_impl.get();
+	EXPECT(desc.renderPass || impl->device.features.test(VKFeature::eDynamicRendering));
+	if (desc.renderPass || desc.colour != vk::Format::eUndefined) { return impl->pipelines.request(desc); }
+	auto resolved = desc;
+	resolved.colour = colourFormat(instance);
+	return impl->pipelines.request(resolved);
+}
+
+VKPipeline Bridge::pipeline(Instance const& instance, VKComputeDesc const& desc) {
+	EXPECT(instance.m_impl);
+	return instance.m_impl->pipelines.request(desc);
+}
+
+std::span<HeapBudget const> Bridge::memoryBudget(Instance const& instance) noexcept {
+	EXPECT(instance.m_impl);
+	auto const& heaps = instance.m_impl->stats.memory.heaps;
+	return {heaps.data(), heaps.size()};
+}
+
+void Bridge::onMemoryBudget(Instance const& instance, float const fraction, VKMemoryCallback callback) {
+	EXPECT(instance.m_impl);
+	instance.m_impl->memory.watch(fraction, std::move(callback));
+}
+
+Result<vk::Result> Bridge::submitCompute(Frame const& frame, std::span<VKComputeRelease const> releases) noexcept {
+	auto impl = frame.m_instance.m_impl.get();
+	auto const ret = impl->frameSync.get().compute.submit(impl->device, releases);
+	if (!ret) { return Error::eInvalidArg; }
+	impl->submits.external();
+	return *ret;
+}
+
+void Bridge::submit(Frame const& frame, VKSubmit const& submit) { frame.m_instance.m_impl->submits.add(submit); }
+
+void Bridge::endRegion(Frame const& frame) noexcept {
+	auto& sync = frame.m_instance.m_impl->frameSync.get();
+	sync.queries.endRegion(sync.cb);
+}
 } // namespace dibs
@@ -0,0 +1,99 @@
+#include <detail/async_compute.hpp>
+#include <detail/expect.hpp>
+#include <limits>
+
+namespace dibs::detail {
+namespace {
+using CPCFB = vk::CommandPoolCreateFlagBits;
+constexpr vk::CommandPoolCreateFlags pool_flags_v = CPCFB::eTransient | CPCFB::eResetCommandBuffer;
+
+vk::CommandBuffer allocate(vk::Device device, vk::CommandPool pool) {
+	return device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(pool, vk::CommandBufferLevel::ePrimary, 1U)).front();
+}
+
+// release (on compute) and acquire (on graphics) must describe the same transfer
+void transfer(vk::CommandBuffer cb, VKComputeRelease const& release, std::uint32_t src, std::uint32_t dst, bool acquire) {
+	vk::AccessFlags const srcAccess = acquire ? vk::AccessFlags() : vk::AccessFlagBits::eShaderWrite;
+	vk::AccessFlags const dstAccess = acquire ? release.dstAccess : vk::AccessFlags();
+	auto const srcStage = acquire ? vk::PipelineStageFlags(vk::PipelineStageFlagBits::eTopOfPipe) : vk::PipelineStageFlagBits::eComputeShader;
+	auto const dstStage = acquire ? release.dstStage : vk::PipelineStageFlags(vk::PipelineStageFlagBits::eBottomOfPipe);
+	if (release.image) {
+		vk::ImageMemoryBarrier ib(srcAccess, dstAccess, release.layout, release.layout, src, dst, release.image, release.range);
+		cb.pipelineBarrier(srcStage, dstStage, {}, {}, {}, ib);
+	} else {
+		vk::BufferMemoryBarrier bb(srcAccess, dstAccess, src, dst, release.buffer, 0U, VK_WHOLE_SIZE);
+		cb.pipelineBarrier(srcStage, dstStage, {}, {}, bb, {});
+	}
+}
+} // namespace
+
+AsyncCompute AsyncCompute::make(VKDevice const& device) {
+	AsyncCompute ret;
+	ret.m_pool = device.device.createCommandPoolUnique(vk::CommandPoolCreateInfo(pool_flags_v, device.compute.family));
+	ret.m_cb = allocate(device.device, *ret.m_pool);
+	ret.m_computed = device.device.createSemaphoreUnique({});
+	ret.m_done = device.device.createFenceUnique({vk::FenceCreateFlagBits::eSignaled});
+	ret.m_releases.reserve(16U);
+	if (device.compute.family != device.queue.family) {
+		ret.m_acquirePool = device.device.createCommandPoolUnique(vk::CommandPoolCreateInfo(pool_flags_v, device.queue.family));
+		ret.m_acquireCb = allocate(device.device, *ret.m_acquirePool);
+	}
+	return ret;
+}
+
+void AsyncCompute::wait(VKDevice const& device) {
+	device.device.waitForFences(*m_done, true, std::numeric_limits<std::uint64_t>::max());
+	m_submitted = false;
+}
+
+vk::CommandBuffer AsyncCompute::cmd() {
+	EXPECT(!m_submitted); // one compute submission per frame
+	if (m_submitted) { return {}; }
+	if (!m_recording) {
+		m_cb.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+		m_recording = true;
+	}
+	return m_cb;
+}
+
+std::optional<vk::Result> AsyncCompute::submit(VKDevice const& device, std::span<VKComputeRelease const> releases) {
+	EXPECT(!m_submitted); // one compute submission per frame
+	if (m_submitted) { return std::nullopt; }
+	EXPECT(m_releases.empty()); // graphics must consume the previous submission's releases first
+	if (!m_recording) { cmd(); }
+	auto const src = device.compute.family, dst = device.queue.family;
+	if (src != dst) {
+		for (auto const& release : releases) { transfer(m_cb, release, src, dst, false); }
+	}
+	m_cb.end();
+	m_recording = false;
+	vk::SubmitInfo info;
+	info.commandBufferCount = 1U;
+	info.pCommandBuffers = &m_cb;
+	// graphics only waits when it consumes results; otherwise compute runs fully decoupled
+	if (!releases.empty()) {
+		info.signalSemaphoreCount = 1U;
+		info.pSignalSemaphores = &*m_computed;
+	}
+	device.device.resetFences(*m_done);
+	auto const ret = device.compute.queue.submit(1U, &info, *m_done);
+	m_submitted = true;
+	if (ret == vk::Result::eSuccess) { m_releases.assign(releases.begin(), releases.end()); }
+	return ret;
+}
+
+AsyncCompute::Wait AsyncCompute::graphicsWait(VKDevice const& device) {
+	Wait ret;
+	if (m_releases.empty()) { return ret; }
+	ret.semaphore = *m_computed;
+	for (auto const& release : m_releases) { ret.stages |= release.dstStage; }
+	if (m_acquireCb) {
+		m_acquireCb.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+		for (auto const& release : m_releases) { transfer(m_acquireCb, release, device.compute.family, device.queue.family, true); }
+		m_acquireCb.end();
+		ret.acquire = m_acquireCb;
+	}
+	m_releases.clear();
+	return ret;
+}
+} // namespace dibs::detail
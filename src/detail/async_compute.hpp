@@ -0,0 +1,41 @@
+#pragma once
+#include <dibs/bridge.hpp>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace dibs::detail {
+// async compute commands for one frame in flight, and the graphics side of their cross-queue dependencies
+class AsyncCompute {
+  public:
+	// what the graphics submission of this frame must wait on
+	struct Wait {
+		vk::Semaphore semaphore;
+		vk::PipelineStageFlags stages;
+		vk::CommandBuffer acquire; // queue family ownership acquires, if any
+	};
+
+	static AsyncCompute make(VKDevice const& device);
+
+	// wait for the previous submission using this slot to complete; starts a new frame
+	void wait(VKDevice const& device);
+	// begun on first call; null once submitted this frame
+	vk::CommandBuffer cmd();
+	bool recording() const noexcept { return m_recording; }
+	// once per frame: nullopt if already submitted (the command buffer and fence are still in flight)
+	std::optional<vk::Result> submit(VKDevice const& device, std::span<VKComputeRelease const> releases);
+	// consumes pending releases
+	Wait graphicsWait(VKDevice const& device);
+
+  private:
+	vk::UniqueCommandPool m_pool;
+	vk::CommandBuffer m_cb;
+	vk::UniqueSemaphore m_computed;
+	vk::UniqueFence m_done;
+	vk::UniqueCommandPool m_acquirePool;
+	vk::CommandBuffer m_acquireCb;
+	std::vector<VKComputeRelease> m_releases;
+	bool m_recording{};
+	bool m_submitted{}; // this frame
+};
+} // namespace dibs::detail
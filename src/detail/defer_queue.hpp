@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <vector>
@@ -8,18 +9,33 @@ class DeferQueue {
   public:
 	DeferQueue(std::size_t buffer = 3U) : m_lists(buffer) {}
 
+	// bytes: memory held by t, for Stats::memory
 	template <typename T>
-	void defer(T t) {
+	void defer(T t, std::uint64_t bytes = 0U) {
 		m_current.push_back(std::make_unique<Wrap<T>>(std::move(t)));
+		m_current.back()->bytes = bytes;
+		m_bytes += bytes;
 	}
 
 	void next() {
+		for (auto const& item : m_lists.front()) { m_bytes -= item->bytes; }
 		m_lists.pop_front();
 		m_lists.push_back(std::move(m_current));
 	}
 
+	// destroys everything now: the device must be idle
+	void clear() {
+		m_current.clear();
+		for (auto& list : m_lists) { list.clear(); }
+		m_bytes = 0U;
+	}
+
+	std::uint64_t bytes() const noexcept { return m_bytes; }
+
   private:
 	struct Base {
+		std::uint64_t bytes{};
+
 		virtual ~Base() = default;
 	};
 	template <typename T>
@@ -32,5 +48,6 @@ class DeferQueue {
 
 	List m_current;
 	std::deque<List> m_lists;
+	std::uint64_t m_bytes{};
 };
 } // namespace dibs::detail
@@ -6,6 +6,7 @@
 	do {                                                                                                                                                       \
 		if (!(predicate)) {                                                                                                                                    \
 			::dibs::trace("Expect failed: {}", #predicate);                                                                                                    \
+			if constexpr (::dibs::trace_v) { ::dibs::logFlush(); }                                                                                             \
 			KTL_DEBUG_TRAP();                                                                                                                                  \
 		}                                                                                                                                                      \
 	} while (false)
@@ -0,0 +1,67 @@
+#include <detail/frame_arena.hpp>
+#include <detail/log.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+namespace dibs::detail {
+void FrameArena::init(std::size_t const bytes) {
+	for (auto& slot : m_slots) { slot.reset(bytes); }
+}
+
+std::pmr::memory_resource& FrameArena::resource(std::size_t const slot) noexcept { return m_slots[slot]; }
+
+void FrameArena::reclaim(std::size_t const slot, FrameArenaStats& out) {
+	auto& s = m_slots[slot];
+	auto const used = s.used();
+	// bytes used by the frame that just completed, including spills
+	out.used = used;
+	out.peak = std::max<std::uint64_t>(out.peak, used);
+	m_spills += s.spills();
+	out.spills = m_spills;
+	auto size = s.size();
+	if (s.spills() > 0U) {
+		// next power of two that would have held the frame
+		size = std::bit_ceil(std::max(used, size + 1U));
+		log("Frame arena slot {} grown to {} KiB", slot, size / 1024U);
+	}
+	s.reset(size);
+	out.capacity = capacity();
+}
+
+std::uint64_t FrameArena::capacity() const noexcept {
+	std::uint64_t ret{};
+	for (auto const& slot : m_slots) { ret += slot.size(); }
+	return ret;
+}
+
+void FrameArena::Slot::reset(std::size_t const size) {
+	auto lock = std::scoped_lock(m_mutex);
+	for (auto const& spill : m_heap) { std::pmr::new_delete_resource()->deallocate(spill.pointer, spill.bytes, spill.alignment); }
+	m_heap.clear();
+	m_spilled = 0U;
+	m_spills = 0U;
+	if (size != m_size) {
+		m_block = std::make_unique_for_overwrite<std::byte[]>(size);
+		m_size = size;
+	}
+	m_offset.store(0U, std::memory_order_relaxed);
+}
+
+void* FrameArena::Slot::do_allocate(std::size_t const bytes, std::size_t const alignment) {
+	auto const base = reinterpret_cast<std::uintptr_t>(m_block.get());
+	auto offset = m_offset.load(std::memory_order_relaxed);
+	for (;;) {
+		auto const aligned = ((base + offset + alignment - 1U) & ~(std::uintptr_t(alignment) - 1U)) - base;
+		if (aligned + bytes > m_size) { break; }
+		if (m_offset.compare_exchange_weak(offset, aligned + bytes, std::memory_order_relaxed)) { return m_block.get() + aligned; }
+	}
+	// full: spill to the heap until the slot is reset
+	auto lock = std::scoped_lock(m_mutex);
+	auto* const ret = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	m_heap.push_back({ret, bytes, alignment});
+	m_spilled += bytes;
+	++m_spills;
+	return ret;
+}
+} // namespace dibs::detail
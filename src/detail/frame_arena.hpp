@@ -0,0 +1,55 @@
+#pragma once
+#include <dibs/bridge.hpp>
+#include <dibs/stats.hpp>
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace dibs::detail {
+// CPU bump allocator per frame in flight (Frame::arena); a slot is reset once its frame's fence has signalled
+class FrameArena {
+  public:
+	static constexpr std::size_t initial_v = 256U << 10U; // per slot
+
+	void init(std::size_t bytes = initial_v);
+	// thread safe; deallocation is a no-op. Spills to the heap when full (counted, and the slot grows on reset)
+	std::pmr::memory_resource& resource(std::size_t slot) noexcept;
+	// the previous frame using slot has completed
+	void reclaim(std::size_t slot, FrameArenaStats& out);
+	std::uint64_t capacity() const noexcept;
+
+  private:
+	class Slot final : public std::pmr::memory_resource {
+	  public:
+		void reset(std::size_t size);
+		std::size_t size() const noexcept { return m_size; }
+		// call once the slot's frame has completed
+		std::size_t used() const noexcept { return m_offset.load(std::memory_order_relaxed) + m_spilled; }
+		std::uint64_t spills() const noexcept { return m_spills; }
+
+	  private:
+		struct Spill {
+			void* pointer{};
+			std::size_t bytes{};
+			std::size_t alignment{};
+		};
+
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+		void do_deallocate(void*, std::size_t, std::size_t) override {}
+		bool do_is_equal(std::pmr::memory_resource const& rhs) const noexcept override { return this == &rhs; }
+
+		std::unique_ptr<std::byte[]> m_block;
+		std::size_t m_size{};
+		std::atomic<std::size_t> m_offset{};
+		std::mutex m_mutex; // spills
+		std::vector<Spill> m_heap;
+		std::size_t m_spilled{};
+		std::uint64_t m_spills{};
+	};
+
+	Slot m_slots[frames_in_flight_v];
+	std::uint64_t m_spills{};
+};
+} // namespace dibs::detail
@@ -0,0 +1,412 @@
+#include <detail/defer_queue.hpp>
+#include <detail/frame_exporter.hpp>
+#include <detail/log.hpp>
+#include <detail/submit_batch.hpp>
+#include <detail/vk_memory.hpp>
+#include <dibs/profile.hpp>
+#include <ktl/fixed_vector.hpp>
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace dibs::detail {
+namespace {
+using SharedBytes = std::shared_ptr<std::byte>;
+
+#if defined(__linux__)
+constexpr bool supported_v = true;
+
+int listenOn(std::string const& path) {
+	sockaddr_un address{};
+	if (path.size() >= sizeof(address.sun_path)) { return -1; }
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.data(), path.size());
+	auto const fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) { return -1; }
+	// a stale socket from a previous run (never anything else): nothing accepts connections on it
+	struct stat st {};
+	if (::lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+		auto const probe = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		bool const refused = probe >= 0 && ::connect(probe, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 && errno == ECONNREFUSED;
+		if (probe >= 0) { ::close(probe); }
+		if (!refused) {
+			warn("Frame export: {} is in use by another process", path);
+			::close(fd);
+			return -1;
+		}
+		::unlink(path.c_str());
+	}
+	if (::bind(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 || ::listen(fd, 1) != 0) {
+		::close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+void unlinkPath(std::string const& path) { ::unlink(path.c_str()); }
+
+int acceptOn(int const listen) { return ::accept4(listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC); }
+
+// bytes received; 0 if nothing is pending, nullopt once the peer has gone
+std::optional<std::size_t> receive(int const fd, void* const buffer, std::size_t const size) {
+	auto const ret = ::recv(fd, buffer, size, MSG_DONTWAIT);
+	if (ret > 0) { return static_cast<std::size_t>(ret); }
+	if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) { return 0U; }
+	return std::nullopt;
+}
+
+bool sendMessage(int const fd, void const* const message, std::size_t const size, std::span<int const> const fds) {
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 2U * frame_export::max_images_v)]{};
+	if (fds.size() > 2U * frame_export::max_images_v) { return false; }
+	iovec iov{const_cast<void*>(message), size};
+	msghdr msg{};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1U;
+	if (!fds.empty()) {
+		msg.msg_control = control;
+		msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+		auto* const cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+		std::memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+	}
+	return ::sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) == static_cast<ssize_t>(size);
+}
+
+// anonymous: unlinked as soon as it is open, the fd (and its mapping) is the only reference
+UniqueFd makeShared(std::size_t const size, std::uint32_t const generation, SharedBytes& out) {
+	auto const name = ktl::kformat("/dibs-export-{}-{}", static_cast<int>(::getpid()), generation);
+	auto ret = UniqueFd(Fd{::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600)});
+	if (!ret) { return {}; }
+	::shm_unlink(name.c_str());
+	if (::ftruncate(ret.get().fd, static_cast<off_t>(size)) != 0) { return {}; }
+	auto* const mapped = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, ret.get().fd, 0);
+	if (mapped == MAP_FAILED) { return {}; }
+	out = SharedBytes(static_cast<std::byte*>(mapped), [size](std::byte* bytes) { ::munmap(bytes, size); });
+	return ret;
+}
+
+void closeFd(int const fd) { ::close(fd); }
+#else
+constexpr bool supported_v = false;
+
+int listenOn(std::string const&) { return -1; }
+void unlinkPath(std::string const&) {}
+int acceptOn(int) { return -1; }
+std::optional<std::size_t> receive(int, void*, std::size_t) { return std::nullopt; }
+bool sendMessage(int, void const*, std::size_t, std::span<int const>) { return false; }
+UniqueFd makeShared(std::size_t, std::uint32_t, SharedBytes&) { return {}; }
+void closeFd(int) {}
+#endif
+
+bool hasExtension(VKDevice const& device, std::string_view const name) {
+	return std::find(device.extensions.begin(), device.extensions.end(), name) != device.extensions.end();
+}
+
+// export / import support of an image like the ones create() makes; nullopt if the format cannot be exported as opaque fds
+std::optional<vk::ExternalMemoryFeatureFlags> exportFeatures(vk::PhysicalDevice const gpu, vk::Format const format, vk::ImageUsageFlags const usage) {
+	static constexpr auto required_v = vk::ExternalMemoryFeatureFlagBits::eExportable | vk::ExternalMemoryFeatureFlagBits::eImportable;
+	vk::PhysicalDeviceExternalImageFormatInfo const external(vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd);
+	vk::PhysicalDeviceImageFormatInfo2 const info(format, vk::ImageType::e2D, vk::ImageTiling::eOptimal, usage, {}, &external);
+	try {
+		auto const properties = gpu.getImageFormatProperties2<vk::ImageFormatProperties2, vk::ExternalImageFormatProperties>(info);
+		auto const ret = properties.get<vk::ExternalImageFormatProperties>().externalMemoryProperties.externalMemoryFeatures;
+		if ((ret & required_v) != required_v) { return std::nullopt; }
+		return ret;
+	} catch (vk::SystemError const&) { return std::nullopt; }
+}
+
+vk::ImageMemoryBarrier imageBarrier(vk::Image const image, vk::ImageLayout const from, vk::ImageLayout const to) {
+	vk::ImageMemoryBarrier ret;
+	ret.image = image;
+	ret.oldLayout = from;
+	ret.newLayout = to;
+	ret.srcQueueFamilyIndex = ret.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	ret.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0U, 1U, 0U, 1U);
+	return ret;
+}
+} // namespace
+
+void Fd::Deleter::operator()(Fd const fd) const noexcept { closeFd(fd.fd); }
+
+std::unique_ptr<FrameExporter> FrameExporter::make(VKDevice const& device, ExportConfig const& config, DeferQueue& defer) {
+	if (config.socket.empty()) { return {}; }
+	if constexpr (!supported_v) {
+		warn("Frame export is only supported on Linux");
+		return {};
+	}
+	auto listen = UniqueFd(Fd{listenOn(config.socket)});
+	if (!listen) {
+		warn("Frame export: failed to listen on {}", config.socket);
+		return {};
+	}
+	bool const external = hasExtension(device, VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME) && hasExtension(device, VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME);
+	auto ret = std::make_unique<FrameExporter>();
+	ret->m_device = &device;
+	ret->m_defer = &defer;
+	ret->m_mode = external ? frame_export::Mode::eExternalMemory : frame_export::Mode::eSharedMemory;
+	ret->m_count = std::clamp(config.images, 1U, frame_export::max_images_v);
+	ret->m_path = config.socket;
+	ret->m_listen = std::move(listen);
+	ret->m_stats.listening = true;
+	ret->m_stats.external = external;
+	log("Frame export: listening on {} ({}, {} images)", config.socket, external ? "external memory" : "shared memory", ret->m_count);
+	return ret;
+}
+
+FrameExporter::~FrameExporter() {
+	if (m_listen) { unlinkPath(m_path); }
+}
+
+void FrameExporter::update(std::size_t const slot, FrameExportStats& out) {
+	DIBS_ZONE("dibs::frame_export");
+	if (!m_client) {
+		m_client = UniqueFd(Fd{acceptOn(m_listen.get().fd)});
+		if (m_client) { log("Frame export: consumer connected"); }
+	}
+	if (m_client) {
+		std::byte buffer[frame_export::max_message_v];
+		for (;;) {
+			auto const received = receive(m_client.get().fd, buffer, sizeof(buffer));
+			if (!received) {
+				disconnect();
+				break;
+			}
+			if (*received == 0U) { break; }
+			if (*received < sizeof(frame_export::Release)) { continue; }
+			frame_export::Release release;
+			std::memcpy(&release, buffer, sizeof(release));
+			// releases of images since recreated are stale
+			if (release.type != frame_export::Type::eRelease || release.generation != m_generation || release.index >= m_images.images.size()) { continue; }
+			auto& image = m_images.images[release.index];
+			if (image.state == State::eConsumer) { image.state = State::eFree; }
+		}
+	}
+	for (std::uint32_t i = 0; i < m_images.images.size(); ++i) {
+		auto& image = m_images.images[i];
+		// recorded into a frame that was never submitted
+		if (image.state == State::eRecorded) { image.state = State::eFree; }
+		if (image.state != State::eReadback || image.slot != slot) { continue; }
+		// slot's fence has signalled: the readback is complete
+		auto const size = static_cast<std::size_t>(m_images.config.size);
+		std::memcpy(m_images.shared.get() + i * size, image.mapped, size);
+		publish(image, i);
+	}
+	out = m_stats;
+	out.connected = static_cast<bool>(m_client);
+	out.generation = m_generation;
+}
+
+void FrameExporter::record(vk::CommandBuffer const cb, VKImage const& src, vk::Format const format, std::size_t const slot, std::uint64_t const frame,
+						   SubmitBatch& submits) {
+	if (!m_client) { return; }
+	auto const& config = m_images.config;
+	if (m_images.images.empty() || config.width != src.extent.width || config.height != src.extent.height || config.format != std::uint32_t(format)) {
+		try {
+			if (!create(src, format) || !sendConfig()) {
+				warn("Frame export: failed to share images, disconnecting");
+				disconnect();
+				return;
+			}
+		} catch (vk::SystemError const& e) {
+			warn("Frame export: {}", e.what());
+			disconnect();
+			return;
+		}
+	}
+	auto const it = std::find_if(m_images.images.begin(), m_images.images.end(), [](Image const& i) { return i.state == State::eFree; });
+	if (it == m_images.images.end()) {
+		++m_stats.dropped;
+		return;
+	}
+	auto& image = *it;
+	image.slot = slot;
+	image.frame = frame;
+	using Stage = vk::PipelineStageFlagBits;
+	using Access = vk::AccessFlagBits;
+	using Layout = vk::ImageLayout;
+	vk::ImageSubresourceLayers const layers(vk::ImageAspectFlagBits::eColor, 0U, 0U, 1U);
+	auto const extent = vk::Extent3D(src.extent.width, src.extent.height, 1U);
+	// the frame's passes have transitioned src for presentation
+	auto toSrc = imageBarrier(src.image, Layout::ePresentSrcKHR, Layout::eTransferSrcOptimal);
+	toSrc.srcAccessMask = Access::eMemoryWrite;
+	toSrc.dstAccessMask = Access::eTransferRead;
+	auto toPresent = imageBarrier(src.image, Layout::eTransferSrcOptimal, Layout::ePresentSrcKHR);
+	if (config.mode == frame_export::Mode::eExternalMemory) {
+		auto toDst = imageBarrier(*image.image, Layout::eUndefined, Layout::eTransferDstOptimal);
+		toDst.dstAccessMask = Access::eTransferWrite;
+		vk::ImageMemoryBarrier const before[] = {toSrc, toDst};
+		cb.pipelineBarrier(Stage::eAllCommands, Stage::eTransfer, {}, {}, {}, before);
+		vk::ImageCopy region;
+		region.srcSubresource = region.dstSubresource = layers;
+		region.extent = extent;
+		cb.copyImage(src.image, Layout::eTransferSrcOptimal, *image.image, Layout::eTransferDstOptimal, region);
+		// release to the consumer's queue
+		auto release = imageBarrier(*image.image, Layout::eTransferDstOptimal, Layout::eGeneral);
+		release.srcAccessMask = Access::eTransferWrite;
+		release.srcQueueFamilyIndex = m_device->queue.family;
+		release.dstQueueFamilyIndex = VK_QUEUE_FAMILY_EXTERNAL;
+		vk::ImageMemoryBarrier const after[] = {toPresent, release};
+		cb.pipelineBarrier(Stage::eTransfer, Stage::eBottomOfPipe, {}, {}, {}, after);
+		// signalled after the frame's commands, in the same queue submission
+		auto const semaphore = *image.semaphore;
+		auto signal = VKSubmit{};
+		signal.signals = {&semaphore, 1U};
+		signal.afterFrame = true;
+		submits.add(signal);
+		image.state = State::eRecorded;
+	} else {
+		cb.pipelineBarrier(Stage::eAllCommands, Stage::eTransfer, {}, {}, {}, toSrc);
+		vk::BufferImageCopy region;
+		region.imageSubresource = layers;
+		region.imageExtent = extent;
+		cb.copyImageToBuffer(src.image, Layout::eTransferSrcOptimal, *image.buffer, region);
+		auto const toHost = vk::BufferMemoryBarrier(Access::eTransferWrite, Access::eHostRead, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, *image.buffer, 0U,
+													VK_WHOLE_SIZE);
+		cb.pipelineBarrier(Stage::eTransfer, Stage::eHost, {}, {}, toHost, {});
+		cb.pipelineBarrier(Stage::eTransfer, Stage::eBottomOfPipe, {}, {}, {}, toPresent);
+		image.state = State::eReadback;
+	}
+}
+
+void FrameExporter::submitted() {
+	for (std::uint32_t i = 0; i < m_images.images.size(); ++i) {
+		if (m_images.images[i].state == State::eRecorded) { publish(m_images.images[i], i); }
+	}
+}
+
+bool FrameExporter::create(VKImage const& src, vk::Format const format) {
+	static constexpr auto handle_v = vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd;
+	static constexpr vk::ImageUsageFlags usage_v = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eSampled;
+	auto const device = m_device->device;
+	auto images = Images{};
+	auto& config = images.config;
+	config.mode = m_mode;
+	auto features = std::optional<vk::ExternalMemoryFeatureFlags>();
+	if (m_mode == frame_export::Mode::eExternalMemory) {
+		features = exportFeatures(m_device->gpu.device, format, usage_v);
+		// per generation: the swapchain format may change
+		if (!features) {
+			warn("Frame export: format {} is not exportable, using shared memory", static_cast<int>(format));
+			config.mode = frame_export::Mode::eSharedMemory;
+		}
+	}
+	config.generation = m_generation + 1U;
+	config.count = m_count;
+	config.width = src.extent.width;
+	config.height = src.extent.height;
+	config.format = static_cast<std::uint32_t>(format);
+	auto const ids = m_device->gpu.device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>().get<vk::PhysicalDeviceIDProperties>();
+	std::memcpy(config.deviceUuid, ids.deviceUUID.data(), sizeof(config.deviceUuid));
+	std::memcpy(config.driverUuid, ids.driverUUID.data(), sizeof(config.driverUuid));
+	for (std::uint32_t i = 0; i < m_count; ++i) {
+		auto& image = images.images.emplace_back();
+		if (config.mode == frame_export::Mode::eExternalMemory) {
+			vk::ExternalMemoryImageCreateInfo const external(handle_v);
+			vk::ImageCreateInfo info;
+			info.pNext = &external;
+			info.imageType = vk::ImageType::e2D;
+			info.format = format;
+			info.extent = vk::Extent3D(src.extent.width, src.extent.height, 1U);
+			info.mipLevels = info.arrayLayers = 1U;
+			info.usage = usage_v;
+			image.image = device.createImageUnique(info);
+			auto const chain = device.getImageMemoryRequirements2<vk::MemoryRequirements2, vk::MemoryDedicatedRequirements>(*image.image);
+			auto const& requirements = chain.get<vk::MemoryRequirements2>().memoryRequirements;
+			bool const dedicated =
+				(*features & vk::ExternalMemoryFeatureFlagBits::eDedicatedOnly) || chain.get<vk::MemoryDedicatedRequirements>().requiresDedicatedAllocation;
+			auto const type = memoryType(m_device->gpu.memory, requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+			if (!type) { return false; }
+			// the consumer must import with the same type, size and dedication
+			vk::MemoryDedicatedAllocateInfo const dedication(*image.image);
+			vk::ExportMemoryAllocateInfo const exported(handle_v, dedicated ? &dedication : nullptr);
+			image.memory = device.allocateMemoryUnique(vk::MemoryAllocateInfo(requirements.size, *type, &exported));
+			device.bindImageMemory(*image.image, *image.memory, 0U);
+			config.size = requirements.size;
+			config.memoryType = *type;
+			config.dedicated = dedicated ? 1U : 0U;
+			vk::ExportSemaphoreCreateInfo const semaphore(vk::ExternalSemaphoreHandleTypeFlagBits::eOpaqueFd);
+			image.semaphore = device.createSemaphoreUnique(vk::SemaphoreCreateInfo({}, &semaphore));
+			config.usage = static_cast<std::uint32_t>(static_cast<VkImageUsageFlags>(usage_v));
+		} else {
+			// tightly packed rows
+			config.size = vk::DeviceSize(src.extent.width) * src.extent.height * texelBytes(format);
+			image.buffer = device.createBufferUnique(vk::BufferCreateInfo({}, config.size, vk::BufferUsageFlagBits::eTransferDst));
+			auto const requirements = device.getBufferMemoryRequirements(*image.buffer);
+			using MPFB = vk::MemoryPropertyFlagBits;
+			image.memory = allocate(device, m_device->gpu.memory, requirements, MPFB::eHostVisible | MPFB::eHostCoherent | MPFB::eHostCached);
+			if (!image.memory) { image.memory = allocate(device, m_device->gpu.memory, requirements, MPFB::eHostVisible | MPFB::eHostCoherent); }
+			if (!image.memory) { return false; }
+			device.bindBufferMemory(*image.buffer, *image.memory, 0U);
+			image.mapped = static_cast<std::byte const*>(device.mapMemory(*image.memory, 0U, VK_WHOLE_SIZE));
+		}
+	}
+	if (config.mode == frame_export::Mode::eSharedMemory) {
+		images.sharedFd = makeShared(static_cast<std::size_t>(config.size) * m_count, config.generation, images.shared);
+		if (!images.sharedFd) { return false; }
+	}
+	// the previous images may still be in use by frames in flight
+	if (!m_images.images.empty()) { m_defer->defer(std::move(m_images)); }
+	m_images = std::move(images);
+	m_generation = m_images.config.generation;
+	m_stats.external = m_images.config.mode == frame_export::Mode::eExternalMemory;
+	log("Frame export: {}x{} images (generation {})", config.width, config.height, m_generation);
+	return true;
+}
+
+bool FrameExporter::sendConfig() {
+	ktl::fixed_vector<int, 2U * frame_export::max_images_v> fds;
+	bool const external = m_images.config.mode == frame_export::Mode::eExternalMemory;
+	if (external) {
+		static constexpr auto memory_v = vk::ExternalMemoryHandleTypeFlagBits::eOpaqueFd;
+		static constexpr auto semaphore_v = vk::ExternalSemaphoreHandleTypeFlagBits::eOpaqueFd;
+		auto const device = m_device->device;
+		for (auto const& image : m_images.images) { fds.push_back(device.getMemoryFdKHR(vk::MemoryGetFdInfoKHR(*image.memory, memory_v))); }
+		for (auto const& image : m_images.images) { fds.push_back(device.getSemaphoreFdKHR(vk::SemaphoreGetFdInfoKHR(*image.semaphore, semaphore_v))); }
+	} else {
+		fds.push_back(m_images.sharedFd.get().fd);
+	}
+	auto const ret = send(&m_images.config, sizeof(m_images.config), {fds.data(), fds.size()});
+	// the consumer holds its own references now
+	if (external) {
+		for (auto const fd : fds) { closeFd(fd); }
+	}
+	return ret;
+}
+
+bool FrameExporter::send(void const* const message, std::size_t const size, std::span<int const> const fds) {
+	return m_client && sendMessage(m_client.get().fd, message, size, fds);
+}
+
+void FrameExporter::publish(Image& image, std::uint32_t const index) {
+	auto message = frame_export::Frame{};
+	message.generation = m_generation;
+	message.index = index;
+	message.frame = image.frame;
+	// a consumer that has stopped reading is dropped rather than waited on
+	if (!send(&message, sizeof(message))) {
+		disconnect();
+		return;
+	}
+	image.state = State::eConsumer;
+	++m_stats.exported;
+}
+
+void FrameExporter::disconnect() {
+	if (m_client) { log("Frame export: consumer disconnected"); }
+	m_client = {};
+	if (!m_images.images.empty()) { m_defer->defer(std::move(m_images)); }
+	m_images = {};
+}
+} // namespace dibs::detail
@@ -0,0 +1,91 @@
+#pragma once
+#include <detail/unique.hpp>
+#include <detail/vk_surface.hpp>
+#include <dibs/bridge.hpp>
+#include <dibs/frame_export.hpp>
+#include <dibs/stats.hpp>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace dibs::detail {
+class DeferQueue;
+class SubmitBatch;
+
+struct Fd {
+	int fd{-1};
+
+	bool operator==(Fd const&) const = default;
+
+	struct Deleter {
+		void operator()(Fd fd) const noexcept;
+	};
+};
+
+using UniqueFd = Unique<Fd, Fd::Deleter>;
+
+// Builder::exportFrames: copies each presented image into images shared with one consumer process (Linux only).
+// Zero-copy with VK_KHR_external_memory_fd / VK_KHR_external_semaphore_fd, else readbacks into a shared memory ring
+class FrameExporter {
+  public:
+	// swapchain usage required
+	static constexpr vk::ImageUsageFlags src_usage_v = vk::ImageUsageFlagBits::eTransferSrc;
+
+	// null if unavailable; images are retired into defer
+	static std::unique_ptr<FrameExporter> make(VKDevice const& device, ExportConfig const& config, DeferQueue& defer);
+
+	FrameExporter() = default;
+	FrameExporter(FrameExporter&&) = delete;
+	FrameExporter& operator=(FrameExporter&&) = delete;
+	~FrameExporter();
+
+	// Frame construction, once slot's fence has signalled: accepts a consumer, reads its releases, publishes completed readbacks
+	void update(std::size_t slot, FrameExportStats& out);
+	// src: in ePresentSrcKHR after the frame's passes; returned there. Nothing is recorded without a consumer or a free image.
+	// Adds the export semaphore signal to submits
+	void record(vk::CommandBuffer cb, VKImage const& src, vk::Format format, std::size_t slot, std::uint64_t frame, SubmitBatch& submits);
+	// the frame's commands were submitted
+	void submitted();
+
+  private:
+	enum class State : std::uint8_t { eFree, eRecorded, eReadback, eConsumer };
+
+	struct Image {
+		vk::UniqueDeviceMemory memory;
+		// eExternalMemory
+		vk::UniqueImage image;
+		vk::UniqueSemaphore semaphore;
+		// eSharedMemory: readback
+		vk::UniqueBuffer buffer;
+		std::byte const* mapped{};
+		State state{};
+		std::size_t slot{};
+		std::uint64_t frame{};
+	};
+
+	struct Images {
+		std::vector<Image> images;
+		std::shared_ptr<std::byte> shared; // mapped shared memory ring
+		UniqueFd sharedFd;
+		frame_export::Config config;
+	};
+
+	bool create(VKImage const& src, vk::Format format);
+	bool send(void const* message, std::size_t size, std::span<int const> fds = {});
+	bool sendConfig();
+	void publish(Image& image, std::uint32_t index);
+	void disconnect();
+
+	VKDevice const* m_device{};
+	DeferQueue* m_defer{};
+	frame_export::Mode m_mode{}; // preferred: Config::mode of each generation falls back to eSharedMemory for unexportable formats
+	std::uint32_t m_count{};
+	std::string m_path;
+	UniqueFd m_listen;
+	UniqueFd m_client;
+	Images m_images;
+	std::uint32_t m_generation{};
+	FrameExportStats m_stats;
+};
+} // namespace dibs::detail
@@ -0,0 +1,44 @@
+#include <detail/frame_pacer.hpp>
+#include <algorithm>
+#include <thread>
+
+namespace dibs::detail {
+namespace {
+using namespace std::chrono_literals;
+
+constexpr auto min_spin_v = std::chrono::duration_cast<FramePacer::Clock::duration>(200us);
+constexpr auto max_spin_v = std::chrono::duration_cast<FramePacer::Clock::duration>(4ms);
+
+float ms(FramePacer::Clock::duration const d) noexcept { return std::chrono::duration<float, std::milli>(d).count(); }
+} // namespace
+
+void FramePacer::period(Clock::duration const period) noexcept {
+	m_period = period;
+	m_deadline = m_wake = {};
+}
+
+FramePacer::Clock::duration FramePacer::wait(PacingStats& out) {
+	if (m_period <= Clock::duration::zero()) { return {}; }
+	auto const start = Clock::now();
+	m_deadline = m_deadline == Clock::time_point{} ? start : m_deadline + m_period;
+	if (start > m_deadline) {
+		// the frame overran: restart the schedule instead of bursting to catch up
+		if (m_wake != Clock::time_point{}) { ++out.missed; }
+		m_deadline = start;
+	} else {
+		auto const spin = std::clamp(m_oversleep * 2, min_spin_v, max_spin_v);
+		for (auto now = start; m_deadline - now > spin; now = Clock::now()) {
+			auto const request = m_deadline - now - spin;
+			std::this_thread::sleep_for(request);
+			auto const overslept = std::max(Clock::now() - now - request, Clock::duration::zero());
+			m_oversleep += (overslept - m_oversleep) / 8;
+		}
+		while (Clock::now() < m_deadline) { std::this_thread::yield(); }
+	}
+	auto const wake = Clock::now();
+	out.lateMs.push(ms(wake - m_deadline));
+	if (m_wake != Clock::time_point{}) { out.intervalMs.push(ms(wake - m_wake)); }
+	m_wake = wake;
+	return wake - start;
+}
+} // namespace dibs::detail
@@ -0,0 +1,24 @@
+#pragma once
+#include <dibs/stats.hpp>
+#include <chrono>
+
+namespace dibs::detail {
+// waits for evenly spaced deadlines: coarse sleep, then a short spin for sub-millisecond accuracy
+class FramePacer {
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	// zero disables pacing
+	void period(Clock::duration period) noexcept;
+	Clock::duration period() const noexcept { return m_period; }
+
+	// returns time spent waiting
+	Clock::duration wait(PacingStats& out);
+
+  private:
+	Clock::duration m_period{};
+	Clock::time_point m_deadline{};
+	Clock::time_point m_wake{};
+	Clock::duration m_oversleep{}; // moving average of sleep overshoot, sizes the spin window
+};
+} // namespace dibs::detail
@@ -0,0 +1,88 @@
+#include <detail/frame_ring.hpp>
+#include <detail/log.hpp>
+#include <detail/vk_memory.hpp>
+#include <algorithm>
+#include <numeric>
+
+namespace dibs::detail {
+namespace {
+// any alignment: callers may pass a non power of two (eg a vertex stride)
+constexpr vk::DeviceSize alignUp(vk::DeviceSize const value, vk::DeviceSize const alignment) noexcept {
+	return (value + alignment - 1U) / alignment * alignment;
+}
+
+// host visible and coherent, preferring system memory: on GPUs without resizable BAR, device local host visible memory is a small heap
+vk::UniqueDeviceMemory allocateHost(vk::Device const device, vk::PhysicalDeviceMemoryProperties const& props, vk::MemoryRequirements const& mr) {
+	using MPFB = vk::MemoryPropertyFlagBits;
+	static constexpr vk::MemoryPropertyFlags host_v = MPFB::eHostVisible | MPFB::eHostCoherent;
+	for (std::uint32_t i = 0; i < props.memoryTypeCount; ++i) {
+		auto const flags = props.memoryTypes[i].propertyFlags;
+		if ((mr.memoryTypeBits & (1U << i)) && (flags & host_v) == host_v && !(flags & MPFB::eDeviceLocal)) {
+			return device.allocateMemoryUnique(vk::MemoryAllocateInfo(mr.size, i));
+		}
+	}
+	return allocate(device, props, mr, host_v);
+}
+} // namespace
+
+void FrameRing::init(VKDevice const& device) {
+	m_device = &device;
+	m_minAlignment = std::max(device.gpu.properties.limits.minUniformBufferOffsetAlignment, vk::DeviceSize(1U));
+	for (auto& slot : m_slots) { slot.block = makeBlock(initial_v, false); }
+}
+
+VKFrameAlloc FrameRing::allocate(std::size_t const slot, vk::DeviceSize const size, vk::DeviceSize const alignment) {
+	auto const align = alignment > 0U ? std::lcm(alignment, m_minAlignment) : m_minAlignment;
+	auto lock = std::scoped_lock(m_mutex);
+	auto& s = m_slots[slot];
+	auto offset = alignUp(s.offset, align);
+	if (!s.block.mapped || offset + size > s.block.size) {
+		// grow: earlier suballocations this frame stay valid in the retired block
+		auto capacity = std::max(s.block.size, initial_v);
+		while (capacity < size) { capacity *= 2U; }
+		capacity *= 2U;
+		auto block = makeBlock(capacity, true);
+		if (!block.mapped) { return {}; }
+		++m_overflows;
+		log("Frame ring slot {} grown to {} KiB", slot, capacity / 1024U);
+		if (s.block.buffer) { s.retired.push_back(std::move(s.block)); }
+		s.block = std::move(block);
+		offset = 0U;
+	}
+	s.offset = offset + size;
+	return {*s.block.buffer, offset, size, s.block.mapped + offset};
+}
+
+void FrameRing::reclaim(std::size_t const slot, FrameRingStats& out) {
+	auto lock = std::scoped_lock(m_mutex);
+	auto& s = m_slots[slot];
+	// bytes used by the frame that just completed (excluding retired blocks)
+	out.used = s.offset;
+	out.peak = std::max(out.peak, s.offset);
+	out.overflows = m_overflows;
+	out.capacity = 0U;
+	for (auto const& each : m_slots) { out.capacity += each.block.size; }
+	s.retired.clear();
+	s.offset = 0U;
+}
+
+FrameRing::Block FrameRing::makeBlock(vk::DeviceSize const size, bool const grown) const {
+	auto const device = m_device->device;
+	Block ret;
+	ret.buffer = device.createBufferUnique(vk::BufferCreateInfo({}, size, usage_v));
+	auto const requirements = device.getBufferMemoryRequirements(*ret.buffer);
+	using MPFB = vk::MemoryPropertyFlagBits;
+	// initial blocks: device local where the host can map it (resizable BAR / unified memory), else system memory.
+	// Grown blocks (unbounded) stay out of the BAR heap
+	if (!grown) { ret.memory = allocate(device, m_device->gpu.memory, requirements, MPFB::eDeviceLocal | MPFB::eHostVisible | MPFB::eHostCoherent); }
+	if (!ret.memory) { ret.memory = allocateHost(device, m_device->gpu.memory, requirements); }
+	if (!ret.memory) {
+		error("Failed to allocate {} bytes of frame ring memory", size);
+		return {};
+	}
+	device.bindBufferMemory(*ret.buffer, *ret.memory, 0U);
+	ret.mapped = static_cast<std::byte*>(device.mapMemory(*ret.memory, 0U, size));
+	ret.size = size;
+	return ret;
+}
+} // namespace dibs::detail
@@ -0,0 +1,45 @@
+#pragma once
+#include <dibs/bridge.hpp>
+#include <dibs/stats.hpp>
+#include <mutex>
+#include <vector>
+
+namespace dibs::detail {
+// persistently mapped, host-visible linear allocator per frame in flight; a slot is reclaimed once its frame's fence has signalled
+class FrameRing {
+  public:
+	static constexpr vk::DeviceSize initial_v = 1U << 20U; // per slot
+	static constexpr vk::BufferUsageFlags usage_v = vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer |
+													vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer |
+													vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferSrc;
+
+	void init(VKDevice const& device);
+	// thread safe; offsets are aligned to both alignment (any) and minUniformBufferOffsetAlignment
+	VKFrameAlloc allocate(std::size_t slot, vk::DeviceSize size, vk::DeviceSize alignment);
+	// the previous frame using slot has completed
+	void reclaim(std::size_t slot, FrameRingStats& out);
+
+  private:
+	struct Block {
+		vk::UniqueBuffer buffer;
+		vk::UniqueDeviceMemory memory;
+		std::byte* mapped{};
+		vk::DeviceSize size{};
+	};
+
+	struct Slot {
+		Block block;
+		std::vector<Block> retired; // outgrown this frame, still referenced by its commands
+		vk::DeviceSize offset{};
+	};
+
+	// grown: preferably outside device local memory
+	Block makeBlock(vk::DeviceSize size, bool grown) const;
+
+	VKDevice const* m_device{};
+	vk::DeviceSize m_minAlignment{1U};
+	Slot m_slots[frames_in_flight_v];
+	std::uint64_t m_overflows{};
+	std::mutex m_mutex;
+};
+} // namespace dibs::detail
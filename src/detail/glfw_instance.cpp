@@ -68,10 +68,10 @@ struct EventBuilder {
 
 namespace dibs::detail {
 namespace {
-EventStorage::Drop makeDrop(int count, char const** paths) {
-	EventStorage::Drop ret;
+EventStorage::Drop makeDrop(std::pmr::memory_resource* resource, int count, char const** paths) {
+	EventStorage::Drop ret(resource);
 	ret.reserve(std::size_t(count));
-	for (int i = 0; i < count; ++i) { ret.push_back(paths[i]); }
+	for (int i = 0; i < count; ++i) { ret.emplace_back(paths[i]); }
 	return ret;
 }
 
@@ -133,7 +133,8 @@ void onText(GLFWwindow* win, std::uint32_t scancode) {
 
 void onFileDrop(GLFWwindow* win, int count, char const** paths) {
 	if (win == g_glfwData.window && g_glfwData.eventStorage && g_glfwData.events && g_glfwData.eventStorage->drops.has_space()) {
-		g_glfwData.eventStorage->drops.push_back(makeDrop(count, paths));
+		auto& storage = *g_glfwData.eventStorage;
+		storage.drops.push_back(makeDrop(storage.resource, count, paths));
 		g_glfwData.events->push_back(EventBuilder{}(g_glfwData.eventStorage->drops));
 	}
 }
@@ -141,7 +142,7 @@ void onFileDrop(GLFWwindow* win, int count, char const** paths) {
 
 Unique<GlfwInstance, GlfwInstance::Deleter> GlfwInstance::make() {
 	if (glfwInit()) {
-		glfwSetErrorCallback([](int code, char const* szDesc) { log("GLFW Error! [{}]: {}", code, szDesc); });
+		glfwSetErrorCallback([](int code, char const* szDesc) { error("GLFW Error! [{}]: {}", code, szDesc); });
 		return GlfwInstance{true};
 	}
 	return {};
@@ -0,0 +1,116 @@
+#include <detail/gpu_queries.hpp>
+#include <array>
+#include <utility>
+
+namespace dibs::detail {
+namespace {
+using QPSFB = vk::QueryPipelineStatisticFlagBits;
+
+// results are written in ascending bit order, matching PipelineStats
+constexpr vk::QueryPipelineStatisticFlags statistics_v = QPSFB::eInputAssemblyVertices | QPSFB::eInputAssemblyPrimitives |
+														 QPSFB::eVertexShaderInvocations | QPSFB::eClippingInvocations | QPSFB::eClippingPrimitives |
+														 QPSFB::eFragmentShaderInvocations | QPSFB::eComputeShaderInvocations;
+} // namespace
+
+GpuQueries GpuQueries::make(VKDevice const& device) {
+	GpuQueries ret;
+	// frames are only timed on the graphics queue: its family decides (timestampComputeAndGraphics implies every family can)
+	auto const families = device.gpu.device.getQueueFamilyProperties();
+	if (device.queue.family >= families.size()) { return ret; }
+	auto const bits = families[device.queue.family].timestampValidBits;
+	if (bits == 0U) { return ret; }
+	ret.m_mask = bits >= 64U ? ~std::uint64_t{} : (std::uint64_t{1} << bits) - 1U;
+	ret.m_timestamps = device.device.createQueryPoolUnique(vk::QueryPoolCreateInfo({}, vk::QueryType::eTimestamp, query_count_v));
+	if (device.features.test(VKFeature::ePipelineStatistics)) {
+		ret.m_statistics = device.device.createQueryPoolUnique(vk::QueryPoolCreateInfo({}, vk::QueryType::ePipelineStatistics, 1U, statistics_v));
+	}
+	return ret;
+}
+
+std::optional<GpuFrame> GpuQueries::collect(VKDevice const& device) {
+	if (!std::exchange(m_pending, false)) { return std::nullopt; }
+	static constexpr auto flags_v = vk::QueryResultFlagBits::e64;
+	static constexpr auto stride_v = sizeof(std::uint64_t);
+	std::array<std::uint64_t, query_count_v> ts{};
+	auto const count = regionQuery(m_labels.size(), false);
+	// eNotReady (instead of blocking) if the GPU has not finished: this frame's timings are skipped
+	if (device.device.getQueryPoolResults(*m_timestamps, 0U, count, count * stride_v, ts.data(), stride_v, flags_v) != vk::Result::eSuccess) {
+		return std::nullopt;
+	}
+	double const period = device.gpu.properties.limits.timestampPeriod; // ns per tick
+	// bits beyond timestampValidBits are undefined; masking the difference also handles the counter wrapping
+	auto const ms = [&ts, period, mask = m_mask](std::uint32_t begin, std::uint32_t end) {
+		return float(double((ts[end] - ts[begin]) & mask) * period / 1e6);
+	};
+	GpuFrame ret;
+	ret.frame = m_frame;
+	ret.ms = ms(eFrameBegin, eFrameEnd);
+	ret.passesMs = ms(eFrameBegin, eImGuiBegin);
+	ret.imguiMs = ms(eImGuiBegin, eFrameEnd);
+	for (std::size_t i = 0; i < m_labels.size(); ++i) { ret.regions.push_back({m_labels[i], ms(regionQuery(i, false), regionQuery(i, true))}); }
+	if (m_statistics) {
+		std::array<std::uint64_t, 7> stats{};
+		auto const size = stats.size() * stride_v;
+		if (device.device.getQueryPoolResults(*m_statistics, 0U, 1U, size, stats.data(), size, flags_v) == vk::Result::eSuccess) {
+			ret.pipeline = PipelineStats{stats[0], stats[1], stats[2], stats[3], stats[4], stats[5], stats[6]};
+		}
+	}
+	return ret;
+}
+
+vk::QueryPipelineStatisticFlags GpuQueries::inheritedStatistics() const noexcept { return m_statistics ? statistics_v : vk::QueryPipelineStatisticFlags{}; }
+
+void GpuQueries::begin(vk::CommandBuffer const cb, std::uint64_t const frame) {
+	if (!active()) { return; }
+	m_labels.clear();
+	m_open.clear();
+	m_dropped = 0U;
+	m_frame = frame;
+	m_recording = true;
+	cb.resetQueryPool(*m_timestamps, 0U, query_count_v);
+	if (m_statistics) {
+		cb.resetQueryPool(*m_statistics, 0U, 1U);
+		cb.beginQuery(*m_statistics, 0U, {});
+	}
+	cb.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *m_timestamps, eFrameBegin);
+}
+
+void GpuQueries::imgui(vk::CommandBuffer const cb) {
+	if (!m_recording) { return; }
+	cb.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_timestamps, eImGuiBegin);
+}
+
+void GpuQueries::beginRegion(vk::CommandBuffer const cb, char const* label) {
+	if (!m_recording) { return; }
+	if (m_labels.size() == regions_v) {
+		++m_dropped;
+		return;
+	}
+	m_open.push_back(m_labels.size());
+	cb.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *m_timestamps, regionQuery(m_labels.size(), false));
+	m_labels.push_back(label ? label : "(unnamed)");
+}
+
+void GpuQueries::endRegion(vk::CommandBuffer const cb) {
+	if (!m_recording) { return; }
+	if (m_dropped > 0U) {
+		--m_dropped;
+		return;
+	}
+	if (m_open.empty()) { return; }
+	auto const index = m_open.back();
+	m_open.pop_back();
+	cb.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_timestamps, regionQuery(index, true));
+}
+
+void GpuQueries::end(vk::CommandBuffer const cb) {
+	if (!m_recording) { return; }
+	// close any regions left open
+	m_dropped = 0U;
+	while (!m_open.empty()) { endRegion(cb); }
+	cb.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *m_timestamps, eFrameEnd);
+	if (m_statistics) { cb.endQuery(*m_statistics, 0U); }
+	m_recording = false;
+	m_pending = true;
+}
+} // namespace dibs::detail
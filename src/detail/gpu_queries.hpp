@@ -0,0 +1,42 @@
+#pragma once
+#include <dibs/bridge.hpp>
+#include <dibs/stats.hpp>
+
+namespace dibs::detail {
+// timestamp and pipeline statistics queries for one frame in flight; inactive if the graphics queue has no valid timestamp bits
+class GpuQueries {
+  public:
+	static constexpr std::uint32_t regions_v = 16U;
+
+	static GpuQueries make(VKDevice const& device);
+
+	bool active() const noexcept { return static_cast<bool>(m_timestamps); }
+	// to be inherited by secondary command buffers executed while the frame is recorded
+	vk::QueryPipelineStatisticFlags inheritedStatistics() const noexcept;
+
+	// results of the last frame recorded with these queries; must only be called once its fence has signalled (never waits)
+	std::optional<GpuFrame> collect(VKDevice const& device);
+
+	void begin(vk::CommandBuffer cb, std::uint64_t frame);
+	void imgui(vk::CommandBuffer cb);
+	void beginRegion(vk::CommandBuffer cb, char const* label);
+	void endRegion(vk::CommandBuffer cb);
+	void end(vk::CommandBuffer cb);
+
+  private:
+	enum : std::uint32_t { eFrameBegin, eImGuiBegin, eFrameEnd, eFixedCount };
+	static constexpr std::uint32_t query_count_v = eFixedCount + regions_v * 2U;
+
+	static constexpr std::uint32_t regionQuery(std::size_t index, bool end) noexcept { return eFixedCount + std::uint32_t(index) * 2U + (end ? 1U : 0U); }
+
+	vk::UniqueQueryPool m_timestamps;
+	vk::UniqueQueryPool m_statistics;
+	ktl::fixed_vector<char const*, regions_v> m_labels;
+	ktl::fixed_vector<std::size_t, regions_v> m_open;
+	std::uint64_t m_mask{}; // timestampValidBits
+	std::uint32_t m_dropped{}; // open regions beyond capacity
+	std::uint64_t m_frame{};
+	bool m_recording{};
+	bool m_pending{};
+};
+} // namespace dibs::detail
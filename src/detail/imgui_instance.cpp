@@ -2,27 +2,38 @@
 #include <backends/imgui_impl_vulkan.h>
 #include <imgui.h>
 #include <detail/imgui_instance.hpp>
+#include <dibs/profile.hpp>
+#include <iterator>
 #include <limits>
 
 namespace dibs::detail {
 namespace {
+constexpr std::uint32_t descriptors_v = 1000U;
+// per descriptor, for Stats::memory (drivers vary)
+constexpr vk::DeviceSize descriptor_bytes_v = 64U;
+
+// every type the app may allocate from the pool as well (ImGui_ImplVulkan_AddTexture, custom callbacks)
+constexpr vk::DescriptorType pool_types_v[] = {
+	vk::DescriptorType::eSampler,
+	vk::DescriptorType::eCombinedImageSampler,
+	vk::DescriptorType::eSampledImage,
+	vk::DescriptorType::eStorageImage,
+	vk::DescriptorType::eUniformTexelBuffer,
+	vk::DescriptorType::eStorageTexelBuffer,
+	vk::DescriptorType::eUniformBuffer,
+	vk::DescriptorType::eStorageBuffer,
+	vk::DescriptorType::eUniformBufferDynamic,
+	vk::DescriptorType::eStorageBufferDynamic,
+	vk::DescriptorType::eInputAttachment,
+};
+constexpr std::uint32_t pool_type_count_v = static_cast<std::uint32_t>(std::size(pool_types_v));
+
 vk::UniqueDescriptorPool makePool(vk::Device device, std::uint32_t count) {
-	vk::DescriptorPoolSize pool_sizes[] = {
-		{vk::DescriptorType::eSampler, count},
-		{vk::DescriptorType::eCombinedImageSampler, count},
-		{vk::DescriptorType::eSampledImage, count},
-		{vk::DescriptorType::eStorageImage, count},
-		{vk::DescriptorType::eUniformTexelBuffer, count},
-		{vk::DescriptorType::eStorageTexelBuffer, count},
-		{vk::DescriptorType::eUniformBuffer, count},
-		{vk::DescriptorType::eStorageBuffer, count},
-		{vk::DescriptorType::eUniformBufferDynamic, count},
-		{vk::DescriptorType::eStorageBufferDynamic, count},
-		{vk::DescriptorType::eInputAttachment, count},
-	};
+	vk::DescriptorPoolSize pool_sizes[pool_type_count_v];
+	for (std::uint32_t i = 0; i < pool_type_count_v; ++i) { pool_sizes[i] = {pool_types_v[i], count}; }
 	vk::DescriptorPoolCreateInfo dpci;
 	dpci.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet;
-	dpci.poolSizeCount = sizeof(pool_sizes) / sizeof(vk::DescriptorPoolSize);
+	dpci.poolSizeCount = pool_type_count_v;
 	dpci.maxSets = count * dpci.poolSizeCount;
 	dpci.pPoolSizes = pool_sizes;
 	return device.createDescriptorPoolUnique(dpci);
@@ -31,17 +42,46 @@ vk::UniqueDescriptorPool makePool(vk::Device device, std::uint32_t count) {
 
 Unique<ImGuiInstance, ImGuiInstance::Deleter> ImGuiInstance::make(VKDevice const& device, Info const& info) {
 	static vk::Instance s_inst;
-	static vk::DynamicLoader s_dl;
+	static vk::Device s_device;
 	s_inst = device.instance;
-	auto const fn = [](char const* f, void*) { return s_dl.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr")(s_inst, f); };
+	s_device = device.device;
+	auto const fn = [](char const* f, void*) {
+		// device-level functions straight from the driver, as the default dispatcher has them; instance-level ones are null here
+		auto const& dispatch = VULKAN_HPP_DEFAULT_DISPATCHER;
+		if (auto const ret = dispatch.vkGetDeviceProcAddr(s_device, f)) { return ret; }
+		return dispatch.vkGetInstanceProcAddr(s_inst, f);
+	};
 	ImGui_ImplVulkan_LoadFunctions(fn);
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
 	ImGui::StyleColorsDark();
 	ImGui_ImplGlfw_InitForVulkan(info.window, true);
-	ImGui_ImplVulkan_InitInfo initInfo = {};
 	Unique<ImGuiInstance, Deleter> ret;
-	ret.get().pool = makePool(device.device, 1000U);
+	ret.get().pool = makePool(device.device, descriptors_v);
+	if (!ret.get().initVulkan(device, info)) { return {}; }
+	ret.get().use(device, UiRenderer::eBackend);
+	return ret;
+}
+
+void ImGuiInstance::Deleter::operator()(ImGuiInstance const&) const {
+	ImGui_ImplVulkan_Shutdown();
+	ImGui_ImplGlfw_Shutdown();
+	ImGui::DestroyContext();
+}
+
+bool ImGuiInstance::rebuild(VKDevice const& device, Info const& info, Info const& previous) {
+	auto const current = renderer;
+	// the atlas is still set to the old renderer's texture id until use()
+	native.reset();
+	ImGui_ImplVulkan_Shutdown();
+	bool const ret = initVulkan(device, info);
+	if (!ret) { initVulkan(device, previous); }
+	use(device, current);
+	return ret;
+}
+
+bool ImGuiInstance::initVulkan(VKDevice const& device, Info const& info) {
+	ImGui_ImplVulkan_InitInfo initInfo = {};
 	initInfo.Instance = device.instance;
 	initInfo.Device = device.device;
 	initInfo.PhysicalDevice = device.gpu.device;
@@ -50,8 +90,12 @@ Unique<ImGuiInstance, ImGuiInstance::Deleter> ImGuiInstance::make(VKDevice const
 	initInfo.MinImageCount = info.minImageCount;
 	initInfo.ImageCount = info.imageCount;
 	initInfo.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-	initInfo.DescriptorPool = static_cast<VkDescriptorPool>(*ret->pool);
-	if (!ImGui_ImplVulkan_Init(&initInfo, info.renderPass)) { return {}; }
+	initInfo.DescriptorPool = static_cast<VkDescriptorPool>(*pool);
+	if (!info.renderPass) {
+		initInfo.UseDynamicRendering = true;
+		initInfo.ColorAttachmentFormat = static_cast<VkFormat>(info.colourFormat);
+	}
+	if (!ImGui_ImplVulkan_Init(&initInfo, info.renderPass)) { return false; }
 	vk::CommandPoolCreateInfo poolInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, device.queue.family);
 	auto cpool = device.device.createCommandPoolUnique(poolInfo);
 	vk::CommandBufferAllocateInfo commandBufferInfo(*cpool, vk::CommandBufferLevel::ePrimary, 1U);
@@ -66,22 +110,51 @@ Unique<ImGuiInstance, ImGuiInstance::Deleter> ImGuiInstance::make(VKDevice const
 	device.queue.queue.submit(endInfo, *done);
 	device.device.waitForFences(*done, true, std::numeric_limits<std::uint64_t>::max());
 	ImGui_ImplVulkan_DestroyFontUploadObjects();
-	return ret;
+	backendFont = ImGui::GetIO().Fonts->TexID;
+	nativeInfo = {info.renderPass, info.colourFormat};
+	return true;
 }
 
-void ImGuiInstance::Deleter::operator()(ImGuiInstance const&) const {
-	ImGui_ImplVulkan_Shutdown();
-	ImGui_ImplGlfw_Shutdown();
-	ImGui::DestroyContext();
+void ImGuiInstance::use(VKDevice const& device, UiRenderer const renderer) {
+	if (renderer == UiRenderer::eNative && !native) { native = ImGuiRenderer::make(device, nativeInfo); }
+	this->renderer = native ? renderer : UiRenderer::eBackend;
+	auto const id = this->renderer == UiRenderer::eNative ? reinterpret_cast<ImTextureID>(static_cast<VkDescriptorSet>(native->fontSet())) : backendFont;
+	ImGui::GetIO().Fonts->SetTexID(id);
+}
+
+void ImGuiInstance::detach() const { ImGui_ImplGlfw_Shutdown(); }
+
+void ImGuiInstance::attach(GLFWwindow* const window) const {
+	// chains to the callbacks dibs installed on window
+	ImGui_ImplGlfw_InitForVulkan(window, true);
+}
+
+vk::DeviceSize ImGuiInstance::bytes() const noexcept {
+	auto const& fonts = *ImGui::GetIO().Fonts;
+	// both renderers upload the atlas as RGBA8
+	auto const atlas = vk::DeviceSize(fonts.TexWidth) * vk::DeviceSize(fonts.TexHeight) * 4U;
+	return atlas * (native ? 2U : 1U) + vk::DeviceSize(descriptors_v) * pool_type_count_v * descriptor_bytes_v;
 }
 
 void ImGuiInstance::newFrame() const {
+	DIBS_ZONE("dibs::imgui_new_frame");
 	ImGui_ImplVulkan_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
 }
 
-void ImGuiInstance::endFrame() const { ImGui::Render(); }
+void ImGuiInstance::endFrame() const {
+	DIBS_ZONE("dibs::imgui_render");
+	ImGui::Render();
+}
 
-void ImGuiInstance::render(vk::CommandBuffer cb) const { ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cb); }
+void ImGuiInstance::render(vk::CommandBuffer cb, FrameRing& ring, std::size_t const slot) const {
+	auto* const data = ImGui::GetDrawData();
+	if (!data) { return; }
+	if (renderer == UiRenderer::eNative) {
+		native->render(*data, cb, ring, slot);
+	} else {
+		ImGui_ImplVulkan_RenderDrawData(data, cb);
+	}
+}
 } // namespace dibs::detail
@@ -1,5 +1,6 @@
 #pragma once
 #include <detail/unique.hpp>
+#include <detail/imgui_renderer.hpp>
 #include <dibs/bridge.hpp>
 
 struct GLFWwindow;
@@ -11,6 +12,10 @@ struct ImGuiInstance {
 	struct Info;
 
 	vk::UniqueDescriptorPool pool;
+	std::unique_ptr<ImGuiRenderer> native; // created on first use (uploads its own copy of the font atlas)
+	void* backendFont{};					 // ImTextureID of the stock backend's font atlas
+	UiRenderer renderer{UiRenderer::eBackend};
+	ImGuiRenderer::Info nativeInfo;
 
 	bool operator==(ImGuiInstance const& rhs) const { return (!pool && !rhs.pool) || *pool == *rhs.pool; };
 
@@ -20,14 +25,32 @@ struct ImGuiInstance {
 
 	static Unique<ImGuiInstance, Deleter> make(VKDevice const& device, Info const& info);
 
+	// swaps the font atlas texture id (creating the native renderer on first use): call outside newFrame() / endFrame()
+	void use(VKDevice const& device, UiRenderer renderer);
+	// renderer backends only, for a new render pass / colour format: the context, fonts and app textures are kept.
+	// Call with the device idle; on failure the backend is still initialized for the previous info
+	bool rebuild(VKDevice const& device, Info const& info, Info const& previous);
+	// platform backend only: the context, fonts and renderers are kept. Detach before the window is destroyed
+	void detach() const;
+	void attach(GLFWwindow* window) const;
+
+	// estimated: font atlases and descriptor pool
+	vk::DeviceSize bytes() const noexcept;
+
 	void newFrame() const;
 	void endFrame() const;
-	void render(vk::CommandBuffer cb) const;
+	// ring / slot: geometry for the native renderer
+	void render(vk::CommandBuffer cb, FrameRing& ring, std::size_t slot) const;
+
+  private:
+	// Vulkan backend and its font atlas
+	bool initVulkan(VKDevice const& device, Info const& info);
 };
 
 struct ImGuiInstance::Info {
 	GLFWwindow* window{};
-	vk::RenderPass renderPass;
+	vk::RenderPass renderPass; // dynamic rendering if null
+	vk::Format colourFormat{};
 	std::uint32_t minImageCount{};
 	std::uint32_t imageCount{};
 };
@@ -0,0 +1,283 @@
+#include <imgui.h>
+#include <detail/frame_ring.hpp>
+#include <detail/imgui_renderer.hpp>
+#include <detail/pipeline_service.hpp>
+#include <detail/vk_memory.hpp>
+#include <dibs/profile.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+
+namespace dibs::detail {
+namespace {
+// minimal SPIR-V 1.0, equivalent to:
+// layout (push_constant) uniform PC { vec2 scale; vec2 translate; } pc;
+// layout (location = 0) in vec2 pos; layout (location = 1) in vec2 uv; layout (location = 2) in vec4 colour;
+// layout (location = 0) out vec4 outColour; layout (location = 1) out vec2 outUv;
+// void main() { outColour = colour; outUv = uv; gl_Position = vec4(pos * pc.scale + pc.translate, 0.0, 1.0); }
+constexpr std::uint32_t vert_spv_v[] = {
+	0x07230203, 0x00010000, 0x00000000, 0x00000027, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+	0x00000000, 0x00000001, 0x000b000f, 0x00000000, 0x00000019, 0x6e69616d, 0x00000000, 0x0000000f,
+	0x00000010, 0x00000011, 0x00000012, 0x00000013, 0x00000014, 0x00030047, 0x00000007, 0x00000002,
+	0x00050048, 0x00000007, 0x00000000, 0x00000023, 0x00000000, 0x00050048, 0x00000007, 0x00000001,
+	0x00000023, 0x00000008, 0x00040047, 0x0000000f, 0x0000001e, 0x00000000, 0x00040047, 0x00000010,
+	0x0000001e, 0x00000001, 0x00040047, 0x00000011, 0x0000001e, 0x00000002, 0x00040047, 0x00000012,
+	0x0000001e, 0x00000000, 0x00040047, 0x00000013, 0x0000001e, 0x00000001, 0x00040047, 0x00000014,
+	0x0000000b, 0x00000000, 0x00020013, 0x00000001, 0x00030021, 0x00000002, 0x00000001, 0x00030016,
+	0x00000003, 0x00000020, 0x00040017, 0x00000004, 0x00000003, 0x00000002, 0x00040017, 0x00000005,
+	0x00000003, 0x00000004, 0x00040015, 0x00000006, 0x00000020, 0x00000001, 0x0004001e, 0x00000007,
+	0x00000004, 0x00000004, 0x00040020, 0x00000008, 0x00000009, 0x00000007, 0x00040020, 0x0000000a,
+	0x00000009, 0x00000004, 0x00040020, 0x0000000b, 0x00000001, 0x00000004, 0x00040020, 0x0000000c,
+	0x00000001, 0x00000005, 0x00040020, 0x0000000d, 0x00000003, 0x00000004, 0x00040020, 0x0000000e,
+	0x00000003, 0x00000005, 0x0004002b, 0x00000006, 0x00000015, 0x00000000, 0x0004002b, 0x00000006,
+	0x00000016, 0x00000001, 0x0004002b, 0x00000003, 0x00000017, 0x00000000, 0x0004002b, 0x00000003,
+	0x00000018, 0x3f800000, 0x0004003b, 0x00000008, 0x00000009, 0x00000009, 0x0004003b, 0x0000000b,
+	0x0000000f, 0x00000001, 0x0004003b, 0x0000000b, 0x00000010, 0x00000001, 0x0004003b, 0x0000000c,
+	0x00000011, 0x00000001, 0x0004003b, 0x0000000e, 0x00000012, 0x00000003, 0x0004003b, 0x0000000d,
+	0x00000013, 0x00000003, 0x0004003b, 0x0000000e, 0x00000014, 0x00000003, 0x00050036, 0x00000001,
+	0x00000019, 0x00000000, 0x00000002, 0x000200f8, 0x0000001a, 0x0004003d, 0x00000005, 0x0000001b,
+	0x00000011, 0x0003003e, 0x00000012, 0x0000001b, 0x0004003d, 0x00000004, 0x0000001c, 0x00000010,
+	0x0003003e, 0x00000013, 0x0000001c, 0x0004003d, 0x00000004, 0x0000001d, 0x0000000f, 0x00050041,
+	0x0000000a, 0x0000001e, 0x00000009, 0x00000015, 0x0004003d, 0x00000004, 0x0000001f, 0x0000001e,
+	0x00050041, 0x0000000a, 0x00000020, 0x00000009, 0x00000016, 0x0004003d, 0x00000004, 0x00000021,
+	0x00000020, 0x00050085, 0x00000004, 0x00000022, 0x0000001d, 0x0000001f, 0x00050081, 0x00000004,
+	0x00000023, 0x00000022, 0x00000021, 0x00050051, 0x00000003, 0x00000024, 0x00000023, 0x00000000,
+	0x00050051, 0x00000003, 0x00000025, 0x00000023, 0x00000001, 0x00070050, 0x00000005, 0x00000026,
+	0x00000024, 0x00000025, 0x00000017, 0x00000018, 0x0003003e, 0x00000014, 0x00000026, 0x000100fd,
+	0x00010038,
+};
+
+// layout (set = 0, binding = 0) uniform sampler2D tex;
+// layout (location = 0) in vec4 colour; layout (location = 1) in vec2 uv; layout (location = 0) out vec4 outColour;
+// void main() { outColour = colour * texture(tex, uv); }
+constexpr std::uint32_t frag_spv_v[] = {
+	0x07230203, 0x00010000, 0x00000000, 0x00000017, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+	0x00000000, 0x00000001, 0x0008000f, 0x00000004, 0x00000010, 0x6e69616d, 0x00000000, 0x0000000d,
+	0x0000000e, 0x0000000f, 0x00030010, 0x00000010, 0x00000007, 0x00040047, 0x00000009, 0x00000022,
+	0x00000000, 0x00040047, 0x00000009, 0x00000021, 0x00000000, 0x00040047, 0x0000000d, 0x0000001e,
+	0x00000000, 0x00040047, 0x0000000e, 0x0000001e, 0x00000001, 0x00040047, 0x0000000f, 0x0000001e,
+	0x00000000, 0x00020013, 0x00000001, 0x00030021, 0x00000002, 0x00000001, 0x00030016, 0x00000003,
+	0x00000020, 0x00040017, 0x00000004, 0x00000003, 0x00000002, 0x00040017, 0x00000005, 0x00000003,
+	0x00000004, 0x00090019, 0x00000006, 0x00000003, 0x00000001, 0x00000000, 0x00000000, 0x00000000,
+	0x00000001, 0x00000000, 0x0003001b, 0x00000007, 0x00000006, 0x00040020, 0x00000008, 0x00000000,
+	0x00000007, 0x00040020, 0x0000000a, 0x00000001, 0x00000004, 0x00040020, 0x0000000b, 0x00000001,
+	0x00000005, 0x00040020, 0x0000000c, 0x00000003, 0x00000005, 0x0004003b, 0x00000008, 0x00000009,
+	0x00000000, 0x0004003b, 0x0000000b, 0x0000000d, 0x00000001, 0x0004003b, 0x0000000a, 0x0000000e,
+	0x00000001, 0x0004003b, 0x0000000c, 0x0000000f, 0x00000003, 0x00050036, 0x00000001, 0x00000010,
+	0x00000000, 0x00000002, 0x000200f8, 0x00000011, 0x0004003d, 0x00000005, 0x00000012, 0x0000000d,
+	0x0004003d, 0x00000004, 0x00000013, 0x0000000e, 0x0004003d, 0x00000007, 0x00000014, 0x00000009,
+	0x00050057, 0x00000005, 0x00000015, 0x00000014, 0x00000013, 0x00050085, 0x00000005, 0x00000016,
+	0x00000012, 0x00000015, 0x0003003e, 0x0000000f, 0x00000016, 0x000100fd, 0x00010038,
+};
+
+struct Transform {
+	float scale[2];
+	float translate[2];
+};
+
+struct Draw {
+	vk::DescriptorSet texture;
+	vk::Rect2D scissor;
+	std::uint32_t firstIndex{};
+	std::uint32_t count{};
+	std::int32_t vertexOffset{};
+};
+
+vk::DescriptorSet textureSet(ImTextureID const id) noexcept { return vk::DescriptorSet(reinterpret_cast<VkDescriptorSet>(id)); }
+
+vk::UniqueShaderModule makeModule(vk::Device const device, std::span<std::uint32_t const> const spirv) {
+	return device.createShaderModuleUnique({{}, spirv.size_bytes(), spirv.data()});
+}
+
+void uploadFont(VKDevice const& device, vk::Image const image, std::span<std::uint8_t const> const pixels, vk::Extent2D const extent) {
+	auto const& vkd = device.device;
+	auto staging = vkd.createBufferUnique({{}, pixels.size(), vk::BufferUsageFlagBits::eTransferSrc});
+	auto const flags = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+	auto memory = allocate(vkd, device.gpu.memory, vkd.getBufferMemoryRequirements(*staging), flags);
+	vkd.bindBufferMemory(*staging, *memory, 0U);
+	std::memcpy(vkd.mapMemory(*memory, 0U, pixels.size()), pixels.data(), pixels.size());
+	vkd.unmapMemory(*memory);
+	auto pool = vkd.createCommandPoolUnique({vk::CommandPoolCreateFlagBits::eTransient, device.queue.family});
+	auto const cb = vkd.allocateCommandBuffers({*pool, vk::CommandBufferLevel::ePrimary, 1U}).front();
+	cb.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+	vk::ImageMemoryBarrier barrier;
+	barrier.image = image;
+	barrier.subresourceRange = {vk::ImageAspectFlagBits::eColor, 0U, 1U, 0U, 1U};
+	barrier.srcQueueFamilyIndex = barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.oldLayout = vk::ImageLayout::eUndefined;
+	barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+	barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+	cb.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, barrier);
+	vk::BufferImageCopy copy;
+	copy.imageSubresource = {vk::ImageAspectFlagBits::eColor, 0U, 0U, 1U};
+	copy.imageExtent = vk::Extent3D(extent, 1U);
+	cb.copyBufferToImage(*staging, image, vk::ImageLayout::eTransferDstOptimal, copy);
+	barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+	barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+	barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+	cb.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
+	cb.end();
+	auto done = vkd.createFenceUnique({});
+	device.queue.queue.submit(vk::SubmitInfo({}, {}, cb), *done);
+	vkd.waitForFences(*done, true, std::numeric_limits<std::uint64_t>::max());
+}
+} // namespace
+
+std::unique_ptr<ImGuiRenderer> ImGuiRenderer::make(VKDevice const& device, Info const& info) {
+	auto const& vkd = device.device;
+	auto ret = std::make_unique<ImGuiRenderer>();
+	vk::SamplerCreateInfo sci;
+	sci.magFilter = sci.minFilter = vk::Filter::eLinear;
+	sci.mipmapMode = vk::SamplerMipmapMode::eLinear;
+	sci.addressModeU = sci.addressModeV = sci.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+	sci.maxLod = 1000.0f;
+	ret->m_sampler = vkd.createSamplerUnique(sci);
+	// binding 0: combined image sampler, as expected of textures added through the stock backend
+	vk::DescriptorSetLayoutBinding const binding(0U, vk::DescriptorType::eCombinedImageSampler, 1U, vk::ShaderStageFlagBits::eFragment);
+	ret->m_setLayout = vkd.createDescriptorSetLayoutUnique({{}, binding});
+	vk::DescriptorPoolSize const size(vk::DescriptorType::eCombinedImageSampler, 1U);
+	ret->m_pool = vkd.createDescriptorPoolUnique({{}, 1U, size});
+	vk::PushConstantRange const range(vk::ShaderStageFlagBits::eVertex, 0U, sizeof(Transform));
+	ret->m_layout = vkd.createPipelineLayoutUnique({{}, *ret->m_setLayout, range});
+	VKPipelineDesc desc;
+	desc.layout = *ret->m_layout;
+	desc.bindings = {{0U, sizeof(ImDrawVert), vk::VertexInputRate::eVertex}};
+	desc.attributes = {
+		{0U, 0U, vk::Format::eR32G32Sfloat, offsetof(ImDrawVert, pos)},
+		{1U, 0U, vk::Format::eR32G32Sfloat, offsetof(ImDrawVert, uv)},
+		{2U, 0U, vk::Format::eR8G8B8A8Unorm, offsetof(ImDrawVert, col)},
+	};
+	desc.renderPass = info.renderPass;
+	if (!info.renderPass) { desc.colour = info.colourFormat; }
+	auto const vert = makeModule(vkd, vert_spv_v);
+	auto const frag = makeModule(vkd, frag_spv_v);
+	ret->m_pipeline = makeGraphicsPipeline(vkd, {}, desc, *vert, *frag);
+	// font atlas (already built by the stock backend)
+	unsigned char* pixels{};
+	int width{}, height{};
+	ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+	auto const extent = vk::Extent2D(static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height));
+	vk::ImageCreateInfo ici;
+	ici.imageType = vk::ImageType::e2D;
+	ici.format = vk::Format::eR8G8B8A8Unorm;
+	ici.extent = vk::Extent3D(extent, 1U);
+	ici.mipLevels = ici.arrayLayers = 1U;
+	ici.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst;
+	ret->m_font = vkd.createImageUnique(ici);
+	ret->m_fontMemory = allocate(vkd, device.gpu.memory, vkd.getImageMemoryRequirements(*ret->m_font), vk::MemoryPropertyFlagBits::eDeviceLocal);
+	vkd.bindImageMemory(*ret->m_font, *ret->m_fontMemory, 0U);
+	uploadFont(device, *ret->m_font, {pixels, std::size_t(extent.width) * extent.height * 4U}, extent);
+	vk::ImageViewCreateInfo ivci({}, *ret->m_font, vk::ImageViewType::e2D, ici.format);
+	ivci.subresourceRange = {vk::ImageAspectFlagBits::eColor, 0U, 1U, 0U, 1U};
+	ret->m_fontView = vkd.createImageViewUnique(ivci);
+	ret->m_fontSet = vkd.allocateDescriptorSets({*ret->m_pool, *ret->m_setLayout}).front();
+	vk::DescriptorImageInfo const image(*ret->m_sampler, *ret->m_fontView, vk::ImageLayout::eShaderReadOnlyOptimal);
+	vkd.updateDescriptorSets(vk::WriteDescriptorSet(ret->m_fontSet, 0U, 0U, vk::DescriptorType::eCombinedImageSampler, image), {});
+	return ret;
+}
+
+void ImGuiRenderer::render(ImDrawData const& data, vk::CommandBuffer const cb, FrameRing& ring, std::size_t const slot) const {
+	DIBS_ZONE("dibs::imgui_record");
+	auto const width = data.DisplaySize.x * data.FramebufferScale.x;
+	auto const height = data.DisplaySize.y * data.FramebufferScale.y;
+	if (width <= 0.0f || height <= 0.0f || data.TotalVtxCount <= 0) { return; }
+	auto const vertices = vk::DeviceSize(data.TotalVtxCount) * sizeof(ImDrawVert);
+	auto const indices = vk::DeviceSize(data.TotalIdxCount) * sizeof(ImDrawIdx);
+	auto const alloc = ring.allocate(slot, vertices + indices, 0U);
+	if (!alloc) { return; }
+	auto* vtx = alloc.data;
+	auto* idx = alloc.data + vertices;
+	for (int i = 0; i < data.CmdListsCount; ++i) {
+		auto const& list = *data.CmdLists[i];
+		auto const vtxBytes = std::size_t(list.VtxBuffer.Size) * sizeof(ImDrawVert);
+		auto const idxBytes = std::size_t(list.IdxBuffer.Size) * sizeof(ImDrawIdx);
+		std::memcpy(vtx, list.VtxBuffer.Data, vtxBytes);
+		std::memcpy(idx, list.IdxBuffer.Data, idxBytes);
+		vtx += vtxBytes;
+		idx += idxBytes;
+	}
+	auto const extent = vk::Extent2D(static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height));
+	setup(data, cb, alloc, vertices, extent);
+	vk::DescriptorSet bound;
+	std::optional<vk::Rect2D> scissor;
+	Draw pending;
+	auto const flush = [&] {
+		if (pending.count == 0U) { return; }
+		if (pending.texture != bound) {
+			bound = pending.texture;
+			cb.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *m_layout, 0U, bound, {});
+		}
+		if (scissor != pending.scissor) {
+			scissor = pending.scissor;
+			cb.setScissor(0U, *scissor);
+		}
+		cb.drawIndexed(pending.count, 1U, pending.firstIndex, pending.vertexOffset, 0U);
+		pending.count = 0U;
+	};
+	auto const clipOffset = data.DisplayPos;
+	auto const clipScale = data.FramebufferScale;
+	std::int32_t vertexBase{};
+	std::uint32_t indexBase{};
+	for (int i = 0; i < data.CmdListsCount; ++i) {
+		auto const& list = *data.CmdLists[i];
+		for (int c = 0; c < list.CmdBuffer.Size; ++c) {
+			auto const& cmd = list.CmdBuffer[c];
+			if (cmd.UserCallback) {
+				flush();
+				if (cmd.UserCallback == ImDrawCallback_ResetRenderState) {
+					setup(data, cb, alloc, vertices, extent);
+				} else {
+					cmd.UserCallback(&list, &cmd);
+				}
+				// unknown state after a callback
+				bound = vk::DescriptorSet();
+				scissor.reset();
+				continue;
+			}
+			auto const x0 = std::max((cmd.ClipRect.x - clipOffset.x) * clipScale.x, 0.0f);
+			auto const y0 = std::max((cmd.ClipRect.y - clipOffset.y) * clipScale.y, 0.0f);
+			auto const x1 = std::min((cmd.ClipRect.z - clipOffset.x) * clipScale.x, width);
+			auto const y1 = std::min((cmd.ClipRect.w - clipOffset.y) * clipScale.y, height);
+			if (x1 <= x0 || y1 <= y0 || cmd.ElemCount == 0U) { continue; }
+			Draw const draw{
+				textureSet(cmd.TextureId),
+				vk::Rect2D({static_cast<std::int32_t>(x0), static_cast<std::int32_t>(y0)}, {static_cast<std::uint32_t>(x1 - x0), static_cast<std::uint32_t>(y1 - y0)}),
+				indexBase + cmd.IdxOffset,
+				cmd.ElemCount,
+				vertexBase + static_cast<std::int32_t>(cmd.VtxOffset),
+			};
+			// draws are not reordered (blending depends on submission order): merge runs sharing all state
+			bool const mergeable = pending.count > 0U && pending.texture == draw.texture && pending.scissor == draw.scissor &&
+								   pending.vertexOffset == draw.vertexOffset && pending.firstIndex + pending.count == draw.firstIndex;
+			if (mergeable) {
+				pending.count += draw.count;
+				continue;
+			}
+			flush();
+			pending = draw;
+		}
+		vertexBase += list.VtxBuffer.Size;
+		indexBase += static_cast<std::uint32_t>(list.IdxBuffer.Size);
+	}
+	flush();
+}
+
+void ImGuiRenderer::setup(ImDrawData const& data, vk::CommandBuffer const cb, VKFrameAlloc const& alloc, vk::DeviceSize const indexOffset,
+						  vk::Extent2D const extent) const {
+	static constexpr auto index_type_v = sizeof(ImDrawIdx) == 2U ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+	cb.bindPipeline(vk::PipelineBindPoint::eGraphics, *m_pipeline);
+	cb.bindVertexBuffers(0U, alloc.buffer, alloc.offset);
+	cb.bindIndexBuffer(alloc.buffer, alloc.offset + indexOffset, index_type_v);
+	cb.setViewport(0U, vk::Viewport(0.0f, 0.0f, float(extent.width), float(extent.height), 0.0f, 1.0f));
+	Transform transform;
+	transform.scale[0] = 2.0f / data.DisplaySize.x;
+	transform.scale[1] = 2.0f / data.DisplaySize.y;
+	transform.translate[0] = -1.0f - data.DisplayPos.x * transform.scale[0];
+	transform.translate[1] = -1.0f - data.DisplayPos.y * transform.scale[1];
+	cb.pushConstants(*m_layout, vk::ShaderStageFlagBits::eVertex, 0U, sizeof(transform), &transform);
+}
+} // namespace dibs::detail
@@ -0,0 +1,40 @@
+#pragma once
+#include <dibs/bridge.hpp>
+#include <memory>
+
+struct ImDrawData;
+
+namespace dibs::detail {
+class FrameRing;
+
+// records Dear ImGui draw data with one pipeline: geometry is copied into the frame ring (one copy per draw list buffer),
+// consecutive commands sharing a texture and clip rect are merged, and redundant binds / scissors are skipped
+class ImGuiRenderer {
+  public:
+	struct Info {
+		vk::RenderPass renderPass; // dynamic rendering if null
+		vk::Format colourFormat{};
+	};
+
+	// uploads the font atlas (blocks until done)
+	static std::unique_ptr<ImGuiRenderer> make(VKDevice const& device, Info const& info);
+
+	// ImGui texture id of the font atlas while this renderer is in use
+	vk::DescriptorSet fontSet() const noexcept { return m_fontSet; }
+
+	void render(ImDrawData const& data, vk::CommandBuffer cb, FrameRing& ring, std::size_t slot) const;
+
+  private:
+	void setup(ImDrawData const& data, vk::CommandBuffer cb, VKFrameAlloc const& alloc, vk::DeviceSize indexOffset, vk::Extent2D extent) const;
+
+	vk::UniqueSampler m_sampler;
+	vk::UniqueDescriptorSetLayout m_setLayout;
+	vk::UniqueDescriptorPool m_pool;
+	vk::UniquePipelineLayout m_layout;
+	vk::UniquePipeline m_pipeline;
+	vk::UniqueDeviceMemory m_fontMemory;
+	vk::UniqueImage m_font;
+	vk::UniqueImageView m_fontView;
+	vk::DescriptorSet m_fontSet;
+};
+} // namespace dibs::detail
@@ -0,0 +1,234 @@
+#include <detail/expect.hpp>
+#include <detail/job_system.hpp>
+#include <detail/log.hpp>
+#include <dibs/profile.hpp>
+#include <algorithm>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace dibs::detail {
+namespace {
+thread_local JobSystem const* t_system{};
+thread_local std::size_t t_index{};
+thread_local std::shared_ptr<JobState> const* t_job{}; // running on this thread: parent of jobs it pushes
+
+bool pin(std::thread& thread, std::size_t const core) {
+#if defined(_WIN32)
+	return SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << core) != 0;
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+	static_cast<void>(thread);
+	static_cast<void>(core);
+	return false;
+#endif
+}
+
+constexpr std::size_t index(JobPhase const phase) noexcept { return static_cast<std::size_t>(phase); }
+
+// state or an ancestor (which it keeps open) is of phase
+bool holds(JobState const& state, JobPhase const phase) noexcept {
+	for (auto const* current = &state; current; current = current->parent.get()) {
+		if (current->phase == phase) { return true; }
+	}
+	return false;
+}
+} // namespace
+
+void JobSystem::start(JobConfig const& config) {
+	EXPECT(m_workers.empty());
+	auto const hardware = std::max(std::thread::hardware_concurrency(), 2U);
+	auto const count = std::clamp<std::size_t>(config.workers > 0U ? config.workers : hardware - 1U, 1U, max_workers_v);
+	m_stop = false;
+	// every deque exists before any worker can steal
+	for (std::size_t i = 0; i < count; ++i) { m_workers.push_back(std::make_unique<Worker>()); }
+	bool pinned = config.pinCores;
+	for (std::size_t i = 0; i < count; ++i) {
+		auto& thread = m_workers[i]->thread;
+		thread = std::thread([this, i] { run(i); });
+		// leave the first core to the calling (render) thread
+		if (pinned && !pin(thread, (i + 1U) % hardware)) {
+			warn("Failed to pin job workers to cores");
+			pinned = false;
+		}
+	}
+	m_sampled = Clock::now();
+	log("Job system: {} workers", count);
+}
+
+void JobSystem::stop() {
+	if (m_workers.empty()) { return; }
+	{
+		auto lock = std::scoped_lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (auto& worker : m_workers) { worker->thread.join(); }
+	// jobs pushed by other threads after the workers drained
+	while (tryRun(m_workers.size())) {}
+	m_workers.clear();
+}
+
+std::shared_ptr<JobState> JobSystem::push(Work&& work, JobPhase const phase, bool const detached) {
+	auto ret = std::make_shared<JobState>();
+	ret->phase = ret->lane = phase;
+	if (t_job && !detached) {
+		ret->parent = *t_job;
+		ret->parent->pending.fetch_add(1U);
+		if (phase == JobPhase::eAsync) { ret->lane = ret->parent->lane; }
+	}
+	m_phases[index(phase)].fetch_add(1U);
+	auto const lane = ret->lane;
+	auto const self = thread();
+	if (self < m_workers.size()) {
+		auto& worker = *m_workers[self];
+		auto lock = std::scoped_lock(worker.mutex);
+		worker.deques[index(lane)].push_back({std::move(work), ret});
+	} else {
+		auto lock = std::scoped_lock(m_injectMutex);
+		m_inject[index(lane)].push_back({std::move(work), ret});
+	}
+	m_queued.fetch_add(1U);
+	signal(lane);
+	{
+		// a worker checks m_queued under this lock before sleeping: the notify cannot be lost
+		auto lock = std::scoped_lock(m_sleepMutex);
+	}
+	m_wake.notify_one();
+	return ret;
+}
+
+void JobSystem::wait(JobState const& state) {
+	auto& signalled = m_signals[index(state.phase)];
+	for (;;) {
+		// loaded first: a change after the checks below wakes the wait
+		auto const seen = signalled.load(std::memory_order_acquire);
+		if (state.pending.load(std::memory_order_acquire) == 0U) { return; }
+		if (tryRun(thread())) { continue; }
+		signalled.wait(seen, std::memory_order_acquire);
+	}
+}
+
+void JobSystem::wait(JobPhase const phase) {
+	EXPECT(!t_job || !holds(**t_job, phase));
+	auto& signalled = m_signals[index(phase)];
+	for (;;) {
+		auto const seen = signalled.load(std::memory_order_acquire);
+		if (m_phases[index(phase)].load(std::memory_order_acquire) == 0U) { return; }
+		// eg the render thread waiting on eRecord must not pick up a long eAsync compile, only eRecord jobs and their children
+		if (tryRun(thread(), phase)) { continue; }
+		signalled.wait(seen, std::memory_order_acquire);
+	}
+}
+
+std::size_t JobSystem::thread() const noexcept { return t_system == this ? t_index : m_workers.size(); }
+
+void JobSystem::sample(decltype(Stats::workers)& out) {
+	auto const now = Clock::now();
+	auto const elapsed = std::chrono::duration<double, std::nano>(now - std::exchange(m_sampled, now)).count();
+	out.clear();
+	for (auto& worker : m_workers) {
+		// attributed when a job completes: long jobs are approximate
+		auto const busy = worker->busyNs.load(std::memory_order_relaxed);
+		auto const delta = double(busy - std::exchange(worker->sampledNs, busy));
+		WorkerStats stats;
+		stats.busy = elapsed > 0.0 ? std::min(static_cast<float>(delta / elapsed), 1.0f) : 0.0f;
+		stats.jobs = worker->jobs.load(std::memory_order_relaxed);
+		stats.steals = worker->steals.load(std::memory_order_relaxed);
+		out.push_back(stats);
+	}
+}
+
+void JobSystem::run(std::size_t const index) {
+	t_system = this;
+	t_index = index;
+	profile::threadName("dibs::worker");
+	for (;;) {
+		if (tryRun(index)) { continue; }
+		auto lock = std::unique_lock(m_sleepMutex);
+		m_wake.wait(lock, [this] { return m_stop || m_queued.load() > 0U; });
+		if (m_stop && m_queued.load() == 0U) { return; }
+	}
+}
+
+bool JobSystem::tryRun(std::size_t const self, std::optional<JobPhase> const lane) {
+	auto job = take(self, lane);
+	if (!job) { return false; }
+	m_queued.fetch_sub(1U);
+	auto const start = Clock::now();
+	{
+		DIBS_ZONE("dibs::job");
+		auto const previous = std::exchange(t_job, &job->state);
+		job->work();
+		t_job = previous;
+	}
+	if (self < m_workers.size()) {
+		auto& worker = *m_workers[self];
+		worker.busyNs.fetch_add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+		worker.jobs.fetch_add(1U, std::memory_order_relaxed);
+	}
+	finish(*job->state);
+	return true;
+}
+
+std::optional<JobSystem::Job> JobSystem::take(std::size_t const self, std::optional<JobPhase> const lane) {
+	// lane's deque, else every deque (frame phases first)
+	auto const pop = [lane](std::mutex& mutex, Lanes& deques, bool const back) -> std::optional<Job> {
+		auto lock = std::scoped_lock(mutex);
+		auto const first = lane ? index(*lane) : 0U;
+		auto const last = lane ? first + 1U : deques.size();
+		for (auto i = first; i < last; ++i) {
+			auto& deque = deques[i];
+			if (deque.empty()) { continue; }
+			auto& slot = back ? deque.back() : deque.front();
+			auto ret = std::move(slot);
+			if (back) {
+				deque.pop_back();
+			} else {
+				deque.pop_front();
+			}
+			return ret;
+		}
+		return {};
+	};
+	auto const count = m_workers.size();
+	// own jobs newest first (cache-warm), then external submissions, then the oldest jobs of other workers
+	if (self < count) {
+		if (auto ret = pop(m_workers[self]->mutex, m_workers[self]->deques, true)) { return ret; }
+	}
+	if (auto ret = pop(m_injectMutex, m_inject, false)) { return ret; }
+	for (std::size_t i = 1; i <= count; ++i) {
+		auto const victim = (self + i) % count;
+		if (victim == self) { continue; }
+		if (auto ret = pop(m_workers[victim]->mutex, m_workers[victim]->deques, false)) {
+			if (self < count) { m_workers[self]->steals.fetch_add(1U, std::memory_order_relaxed); }
+			return ret;
+		}
+	}
+	return {};
+}
+
+void JobSystem::finish(JobState& state) {
+	// the last of a job and its children to finish completes it, and releases its hold on the parent
+	for (auto* current = &state; current && current->pending.fetch_sub(1U, std::memory_order_acq_rel) == 1U; current = current->parent.get()) {
+		m_phases[index(current->phase)].fetch_sub(1U);
+		signal(current->phase);
+	}
+}
+
+void JobSystem::signal(JobPhase const lane) {
+	m_signals[index(lane)].fetch_add(1U, std::memory_order_release);
+	m_signals[index(lane)].notify_all();
+}
+} // namespace dibs::detail
@@ -0,0 +1,86 @@
+#pragma once
+#include <dibs/jobs.hpp>
+#include <dibs/stats.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace dibs::detail {
+struct JobState {
+	std::atomic<std::uint32_t> pending{1U}; // own work + unfinished children
+	std::shared_ptr<JobState> parent;
+	JobPhase phase{};
+	JobPhase lane{}; // queue: phase, or for eAsync children the lane of the parent (whose phase they keep open)
+};
+
+class JobSystem {
+  public:
+	using Work = Jobs::Work;
+	using Clock = std::chrono::steady_clock;
+
+	JobSystem() = default;
+	JobSystem(JobSystem&&) = delete;
+	JobSystem& operator=(JobSystem&&) = delete;
+	~JobSystem() { stop(); }
+
+	void start(JobConfig const& config);
+	// runs all remaining jobs, then joins workers
+	void stop();
+
+	// detached: no parent even when pushed from a running job (which would otherwise stay pending until this one completes)
+	std::shared_ptr<JobState> push(Work&& work, JobPhase phase, bool detached = false);
+	// help until state has completed, blocking while nothing is runnable
+	void wait(JobState const& state);
+	// help with jobs of phase and their children (only) until all of them have completed, blocking while none are queued.
+	// Not from a job that keeps phase open itself (it would wait on itself)
+	void wait(JobPhase phase);
+
+	std::size_t workers() const noexcept { return m_workers.size(); }
+	std::size_t thread() const noexcept;
+
+	// utilization since the previous call
+	void sample(decltype(Stats::workers)& out);
+
+  private:
+	struct Job {
+		Work work;
+		std::shared_ptr<JobState> state;
+	};
+
+	// one deque per lane, so that waiting on a phase pops in constant time
+	using Lanes = std::array<std::deque<Job>, 3>;
+
+	struct Worker {
+		std::mutex mutex; // deques: owner pushes / pops the back, thieves take the front
+		Lanes deques;
+		std::thread thread;
+		std::atomic<std::uint64_t> busyNs{};
+		std::atomic<std::uint64_t> jobs{};
+		std::atomic<std::uint64_t> steals{};
+		std::uint64_t sampledNs{};
+	};
+
+	void run(std::size_t index);
+	bool tryRun(std::size_t self, std::optional<JobPhase> lane = {});
+	std::optional<Job> take(std::size_t self, std::optional<JobPhase> lane);
+	void finish(JobState& state);
+	void signal(JobPhase lane);
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::mutex m_injectMutex; // jobs pushed from other threads
+	Lanes m_inject;
+	std::atomic<std::size_t> m_queued{};
+	std::array<std::atomic<std::uint32_t>, 3> m_phases{};
+	std::array<std::atomic<std::uint32_t>, 3> m_signals{}; // bumped when a lane gains a job or a phase loses one: waiters block on these
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	bool m_stop{};
+	Clock::time_point m_sampled{};
+};
+} // namespace dibs::detail
@@ -1,6 +1,6 @@
 #pragma once
+#include <dibs/log.hpp>
 #include <ktl/kformat.hpp>
-#include <iostream>
 
 namespace dibs {
 constexpr bool trace_v =
@@ -10,13 +10,40 @@ constexpr bool trace_v =
 	false;
 #endif
 
+// lowest level compiled in: lines below it are discarded at compile time
+constexpr LogLevel log_level_v =
+#if defined(DIBS_LOG_LEVEL)
+	LogLevel(DIBS_LOG_LEVEL);
+#else
+	trace_v ? LogLevel::eDebug : LogLevel::eInfo;
+#endif
+
+namespace detail {
+void logPush(LogLevel level, std::string_view line) noexcept;
+}
+
+template <LogLevel Level, typename... Args>
+void logAt(std::string_view fmt, Args const&... args) {
+	if constexpr (Level >= log_level_v) { detail::logPush(Level, ktl::kformat(fmt, args...)); }
+}
+
 template <typename... Args>
 void log(std::string_view fmt, Args const&... args) {
-	std::cout << ktl::kformat(fmt, args...) << '\n';
+	logAt<LogLevel::eInfo>(fmt, args...);
+}
+
+template <typename... Args>
+void warn(std::string_view fmt, Args const&... args) {
+	logAt<LogLevel::eWarning>(fmt, args...);
+}
+
+template <typename... Args>
+void error(std::string_view fmt, Args const&... args) {
+	logAt<LogLevel::eError>(fmt, args...);
 }
 
 template <typename... Args>
 void trace(std::string_view fmt, Args const&... args) {
-	if constexpr (trace_v) { log(fmt, args...); }
+	if constexpr (trace_v) { logAt<LogLevel::eDebug>(fmt, args...); }
 }
 } // namespace dibs
@@ -0,0 +1,197 @@
+#include <detail/log.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace dibs {
+namespace {
+class StdoutSink : public LogSink {
+  public:
+	void write(LogLevel, std::string_view line) override { std::cout << line << '\n'; }
+	void flush() override { std::cout.flush(); }
+};
+
+class FileSink : public LogSink {
+  public:
+	FileSink(std::ofstream file) noexcept : m_file(std::move(file)) {}
+
+	void write(LogLevel, std::string_view line) override { m_file << line << '\n'; }
+	void flush() override { m_file.flush(); }
+
+  private:
+	std::ofstream m_file;
+};
+
+// bounded lock-free multi-producer single-consumer queue of fixed-size slots (Vyukov), drained by a sink thread.
+// Longer lines claim consecutive slots
+class Logger {
+  public:
+	static constexpr std::size_t capacity_v = 1024U;
+	static constexpr std::size_t line_v = 248U;
+	static constexpr std::size_t max_chain_v = 32U; // slots per line (~8 KiB): longer lines are truncated, with a marker
+	static constexpr std::string_view truncated_v = " [truncated]";
+
+	static Logger& instance() {
+		static Logger s_logger;
+		return s_logger;
+	}
+
+	Logger() : m_sink(makeStdoutSink()) {
+		for (std::size_t i = 0; i < capacity_v; ++i) { m_slots[i].sequence.store(i, std::memory_order_relaxed); }
+		m_line.reserve(max_chain_v * line_v);
+		m_thread = std::thread([this] { run(); });
+	}
+
+	~Logger() {
+		m_stop.store(true);
+		wake();
+		m_thread.join();
+	}
+
+	void push(LogLevel const level, std::string_view const line) noexcept {
+		auto const needed = std::max<std::size_t>((line.size() + line_v - 1U) / line_v, 1U);
+		auto const count = std::min(needed, max_chain_v);
+		auto pos = m_head.load(std::memory_order_relaxed);
+		for (;;) {
+			// slots are released in order: if the last one is free, so are the ones before it
+			auto const last = pos + count - 1U;
+			auto const seq = m_slots[last % capacity_v].sequence.load(std::memory_order_acquire);
+			auto const diff = std::intptr_t(seq) - std::intptr_t(last);
+			if (diff == 0 && m_slots[pos % capacity_v].sequence.load(std::memory_order_acquire) == pos) {
+				if (m_head.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) { break; }
+			} else if (diff < 0) {
+				// full: never block the caller
+				m_dropped.fetch_add(1U, std::memory_order_relaxed);
+				return;
+			} else {
+				pos = m_head.load(std::memory_order_relaxed);
+			}
+		}
+		if (needed > count) { m_truncated.fetch_add(1U, std::memory_order_relaxed); }
+		for (std::size_t i = 0; i < count; ++i) {
+			auto& slot = m_slots[(pos + i) % capacity_v];
+			auto text = line.substr(std::min(i * line_v, line.size()), line_v);
+			slot.level = level;
+			slot.more = i + 1U < count;
+			if (!slot.more && needed > count) {
+				text = text.substr(0U, line_v - truncated_v.size());
+				std::memcpy(slot.text + text.size(), truncated_v.data(), truncated_v.size());
+				slot.length = text.size() + truncated_v.size();
+			} else {
+				slot.length = text.size();
+			}
+			std::memcpy(slot.text, text.data(), text.size());
+			slot.sequence.store(pos + i + 1U, std::memory_order_release);
+		}
+		m_signal.fetch_add(1U);
+		if (m_waiting.load()) { wake(); }
+	}
+
+	void sink(std::unique_ptr<LogSink>&& sink) {
+		auto lock = std::scoped_lock(m_mutex);
+		if (m_sink) { m_sink->flush(); }
+		m_sink = sink ? std::move(sink) : makeStdoutSink();
+	}
+
+	void flush() {
+		// called by a sink (on the logging thread): it cannot wait for itself, and drain() flushes after each batch anyway
+		if (std::this_thread::get_id() == m_thread.get_id()) { return; }
+		auto const target = m_head.load();
+		while (m_written.load() < target) {
+			wake();
+			std::this_thread::yield();
+		}
+		auto lock = std::scoped_lock(m_mutex);
+		m_sink->flush();
+	}
+
+	std::uint64_t dropped() const noexcept { return m_dropped.load(std::memory_order_relaxed); }
+	std::uint64_t truncated() const noexcept { return m_truncated.load(std::memory_order_relaxed); }
+
+  private:
+	struct Slot {
+		std::atomic<std::size_t> sequence;
+		LogLevel level{};
+		bool more{}; // the line continues in the next slot
+		std::size_t length{};
+		char text[line_v];
+	};
+
+	void wake() {
+		m_signal.fetch_add(1U);
+		m_signal.notify_one();
+	}
+
+	bool drain() {
+		bool ret{};
+		auto lock = std::scoped_lock(m_mutex);
+		for (;;) {
+			auto& slot = m_slots[m_tail % capacity_v];
+			if (slot.sequence.load(std::memory_order_acquire) != m_tail + 1U) { break; }
+			auto const text = std::string_view(slot.text, slot.length);
+			if (slot.more || !m_line.empty()) {
+				m_line.append(text);
+				if (!slot.more) {
+					m_sink->write(slot.level, m_line);
+					m_line.clear();
+				}
+			} else {
+				m_sink->write(slot.level, text);
+			}
+			slot.sequence.store(m_tail + capacity_v, std::memory_order_release);
+			m_written.store(++m_tail);
+			ret = true;
+		}
+		if (ret) { m_sink->flush(); }
+		return ret;
+	}
+
+	void run() {
+		while (!m_stop.load()) {
+			auto const signal = m_signal.load();
+			if (drain()) { continue; }
+			// producers only notify when this thread is (about to be) waiting
+			m_waiting.store(true);
+			if (!drain()) { m_signal.wait(signal); }
+			m_waiting.store(false);
+		}
+		drain();
+	}
+
+	std::array<Slot, capacity_v> m_slots;
+	alignas(64) std::atomic<std::size_t> m_head{};
+	alignas(64) std::size_t m_tail{};
+	std::atomic<std::size_t> m_written{};
+	std::atomic<std::uint32_t> m_signal{};
+	std::atomic<bool> m_waiting{};
+	std::atomic<bool> m_stop{};
+	std::atomic<std::uint64_t> m_dropped{};
+	std::atomic<std::uint64_t> m_truncated{};
+	std::string m_line; // slots of a chained line drained so far
+	std::mutex m_mutex; // sink: consumer thread and replacement only
+	std::unique_ptr<LogSink> m_sink;
+	std::thread m_thread;
+};
+} // namespace
+
+std::unique_ptr<LogSink> makeStdoutSink() { return std::make_unique<StdoutSink>(); }
+
+std::unique_ptr<LogSink> makeFileSink(char const* path) {
+	auto file = std::ofstream(path);
+	if (!file) { return {}; }
+	return std::make_unique<FileSink>(std::move(file));
+}
+
+void logSink(std::unique_ptr<LogSink> sink) { Logger::instance().sink(std::move(sink)); }
+void logFlush() { Logger::instance().flush(); }
+std::uint64_t logDropped() noexcept { return Logger::instance().dropped(); }
+std::uint64_t logTruncated() noexcept { return Logger::instance().truncated(); }
+
+void detail::logPush(LogLevel const level, std::string_view const line) noexcept { Logger::instance().push(level, line); }
+} // namespace dibs
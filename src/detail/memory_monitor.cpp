@@ -0,0 +1,53 @@
+#include <detail/expect.hpp>
+#include <detail/memory_monitor.hpp>
+#include <algorithm>
+
+namespace dibs::detail {
+void MemoryMonitor::init(VKDevice const& device) {
+	m_device = &device;
+	m_budget = std::find(device.extensions.begin(), device.extensions.end(), extension_v) != device.extensions.end();
+}
+
+void MemoryMonitor::watch(float const fraction, Callback callback) {
+	EXPECT(fraction > 0.0f);
+	m_watches.push_back({fraction, std::move(callback)});
+}
+
+void MemoryMonitor::update(std::uint64_t const owned, MemoryStats& out) {
+	out.heaps.clear();
+	out.budget = m_budget;
+	if (m_budget) {
+		auto const props = m_device->gpu.device.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		auto const& memory = props.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties;
+		auto const& budget = props.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+		for (std::uint32_t i = 0; i < memory.memoryHeapCount; ++i) {
+			bool const local = static_cast<bool>(memory.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+			out.heaps.push_back({budget.heapBudget[i], budget.heapUsage[i], local});
+		}
+	} else {
+		auto const& memory = m_device->gpu.memory;
+		std::size_t largest = max_heaps_v;
+		for (std::uint32_t i = 0; i < memory.memoryHeapCount; ++i) {
+			auto const& heap = memory.memoryHeaps[i];
+			bool const local = static_cast<bool>(heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal);
+			if (local && (largest == max_heaps_v || heap.size > out.heaps[largest].budget)) { largest = i; }
+			out.heaps.push_back({heap.size, 0U, local});
+		}
+		if (largest < out.heaps.size()) { out.heaps[largest].usage = owned; }
+	}
+	for (auto& watch : m_watches) {
+		for (std::uint32_t i = 0; i < out.heaps.size(); ++i) {
+			auto const& heap = out.heaps[i];
+			auto const bit = 1U << i;
+			auto const fraction = heap.fraction();
+			if (!(watch.above & bit) && fraction >= watch.fraction) {
+				watch.above |= bit;
+				watch.callback(i, heap, true);
+			} else if ((watch.above & bit) && fraction < watch.fraction - hysteresis_v) {
+				watch.above &= ~bit;
+				watch.callback(i, heap, false);
+			}
+		}
+	}
+}
+} // namespace dibs::detail
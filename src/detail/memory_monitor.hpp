@@ -0,0 +1,32 @@
+#pragma once
+#include <dibs/bridge.hpp>
+#include <dibs/stats.hpp>
+#include <vector>
+
+namespace dibs::detail {
+// per heap budgets (VK_EXT_memory_budget where enabled) and threshold callbacks
+class MemoryMonitor {
+  public:
+	using Callback = VKMemoryCallback;
+
+	static constexpr char const* extension_v = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+	// usage must fall this far below a watched fraction before it can fire again
+	static constexpr float hysteresis_v = 0.05f;
+
+	void init(VKDevice const& device);
+	void watch(float fraction, Callback callback);
+	// owned: bytes dibs knows it allocated in device local memory, attributed to the largest such heap without the extension
+	void update(std::uint64_t owned, MemoryStats& out);
+
+  private:
+	struct Watch {
+		float fraction{};
+		Callback callback;
+		std::uint32_t above{}; // heap bits
+	};
+
+	VKDevice const* m_device{};
+	std::vector<Watch> m_watches;
+	bool m_budget{};
+};
+} // namespace dibs::detail
@@ -0,0 +1,246 @@
+#include <detail/expect.hpp>
+#include <detail/job_system.hpp>
+#include <detail/log.hpp>
+#include <detail/pipeline_service.hpp>
+#include <dibs/profile.hpp>
+#include <algorithm>
+
+namespace dibs::detail {
+namespace {
+// FNV-1a, per value
+struct Hasher {
+	std::uint64_t value{14695981039346656037ULL};
+
+	void mix(std::uint64_t const in) noexcept { value = (value ^ in) * 1099511628211ULL; }
+
+	template <typename T>
+	void mix(vk::Flags<T> const flags) noexcept {
+		mix(static_cast<typename vk::Flags<T>::MaskType>(flags));
+	}
+
+	template <typename T>
+		requires(std::is_enum_v<T>)
+	void mix(T const in) noexcept {
+		mix(static_cast<std::uint64_t>(in));
+	}
+
+	template <typename T>
+		requires(vk::isVulkanHandleType<T>::value)
+	void mix(T const handle) noexcept {
+		mix(std::hash<T>{}(handle));
+	}
+
+	void mix(std::span<std::uint32_t const> const words) noexcept {
+		mix(words.size());
+		for (auto const word : words) { mix(word); }
+	}
+};
+
+std::uint64_t hash(std::span<std::uint32_t const> const spirv) noexcept {
+	auto ret = Hasher{};
+	ret.mix(spirv);
+	return ret.value;
+}
+} // namespace
+
+std::size_t PipelineHash::operator()(VKPipelineDesc const& desc) const noexcept {
+	auto ret = Hasher{};
+	ret.mix(desc.vertex);
+	ret.mix(desc.fragment);
+	ret.mix(desc.layout);
+	ret.mix(desc.bindings.size());
+	for (auto const& binding : desc.bindings) {
+		ret.mix(binding.binding);
+		ret.mix(binding.stride);
+		ret.mix(binding.inputRate);
+	}
+	ret.mix(desc.attributes.size());
+	for (auto const& attribute : desc.attributes) {
+		ret.mix(attribute.location);
+		ret.mix(attribute.binding);
+		ret.mix(attribute.format);
+		ret.mix(attribute.offset);
+	}
+	ret.mix(desc.topology);
+	ret.mix(desc.polygonMode);
+	ret.mix(desc.cullMode);
+	ret.mix(desc.frontFace);
+	ret.mix(static_cast<std::uint64_t>(desc.lineWidth * 1000.0f));
+	ret.mix((desc.depthTest ? 1U : 0U) | (desc.depthWrite ? 2U : 0U) | (desc.alphaBlend ? 4U : 0U));
+	ret.mix(desc.depthCompare);
+	ret.mix(desc.renderPass);
+	ret.mix(desc.colour);
+	ret.mix(desc.depth);
+	return static_cast<std::size_t>(ret.value);
+}
+
+std::size_t PipelineHash::operator()(VKComputeDesc const& desc) const noexcept {
+	auto ret = Hasher{};
+	ret.mix(desc.shader);
+	ret.mix(desc.layout);
+	return static_cast<std::size_t>(ret.value);
+}
+
+vk::UniquePipeline makeGraphicsPipeline(vk::Device const device, vk::PipelineCache const cache, VKPipelineDesc const& desc, vk::ShaderModule const vertex,
+									  vk::ShaderModule const fragment) {
+	vk::PipelineShaderStageCreateInfo stages[2];
+	stages[0] = {{}, vk::ShaderStageFlagBits::eVertex, vertex, "main"};
+	std::uint32_t stageCount = 1U;
+	// no fragment shader: depth only
+	if (fragment) { stages[stageCount++] = {{}, vk::ShaderStageFlagBits::eFragment, fragment, "main"}; }
+	vk::PipelineVertexInputStateCreateInfo vertexInput;
+	vertexInput.setVertexBindingDescriptions(desc.bindings).setVertexAttributeDescriptions(desc.attributes);
+	vk::PipelineInputAssemblyStateCreateInfo inputAssembly({}, desc.topology);
+	vk::PipelineViewportStateCreateInfo viewport;
+	viewport.viewportCount = viewport.scissorCount = 1U;
+	vk::PipelineRasterizationStateCreateInfo rasterization;
+	rasterization.polygonMode = desc.polygonMode;
+	rasterization.cullMode = desc.cullMode;
+	rasterization.frontFace = desc.frontFace;
+	rasterization.lineWidth = desc.lineWidth;
+	vk::PipelineMultisampleStateCreateInfo multisample;
+	vk::PipelineDepthStencilStateCreateInfo depthStencil;
+	depthStencil.depthTestEnable = desc.depthTest;
+	depthStencil.depthWriteEnable = desc.depthWrite;
+	depthStencil.depthCompareOp = desc.depthCompare;
+	vk::PipelineColorBlendAttachmentState attachment;
+	using CC = vk::ColorComponentFlagBits;
+	attachment.colorWriteMask = CC::eR | CC::eG | CC::eB | CC::eA;
+	if (desc.alphaBlend) {
+		attachment.blendEnable = true;
+		attachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+		attachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+		attachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+		attachment.dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+	}
+	vk::PipelineColorBlendStateCreateInfo colourBlend;
+	if (desc.renderPass || desc.colour != vk::Format::eUndefined) { colourBlend.setAttachments(attachment); }
+	vk::DynamicState const states[] = {vk::DynamicState::eViewport, vk::DynamicState::eScissor};
+	vk::PipelineDynamicStateCreateInfo dynamic;
+	dynamic.setDynamicStates(states);
+	vk::PipelineRenderingCreateInfo rendering;
+	if (desc.colour != vk::Format::eUndefined) { rendering.setColorAttachmentFormats(desc.colour); }
+	rendering.depthAttachmentFormat = desc.depth;
+	vk::GraphicsPipelineCreateInfo info;
+	info.stageCount = stageCount;
+	info.pStages = stages;
+	info.pVertexInputState = &vertexInput;
+	info.pInputAssemblyState = &inputAssembly;
+	info.pViewportState = &viewport;
+	info.pRasterizationState = &rasterization;
+	info.pMultisampleState = &multisample;
+	info.pDepthStencilState = &depthStencil;
+	info.pColorBlendState = &colourBlend;
+	info.pDynamicState = &dynamic;
+	info.layout = desc.layout;
+	if (desc.renderPass) {
+		info.renderPass = desc.renderPass;
+	} else {
+		info.pNext = &rendering;
+	}
+	return std::move(device.createGraphicsPipelineUnique(cache, info).value);
+}
+
+void PipelineService::init(VKDevice const& device, JobSystem& jobs) {
+	m_device = &device;
+	m_jobs = &jobs;
+	m_cache = device.device.createPipelineCacheUnique({});
+}
+
+VKPipeline PipelineService::request(VKPipelineDesc const& desc) {
+	EXPECT(!desc.vertex.empty() && desc.layout);
+	return request(m_graphics, desc);
+}
+
+VKPipeline PipelineService::request(VKComputeDesc const& desc) {
+	EXPECT(!desc.shader.empty() && desc.layout);
+	return request(m_compute, desc);
+}
+
+void PipelineService::sample(PipelineCompileStats& out) {
+	auto const notReady = m_notReady.load(std::memory_order_relaxed);
+	auto lock = std::scoped_lock(m_mutex);
+	if (notReady != m_sampledNotReady) { ++m_stats.hitchFrames; }
+	m_sampledNotReady = notReady;
+	m_stats.notReady = notReady;
+	out = m_stats;
+}
+
+template <typename Desc>
+VKPipeline PipelineService::request(Map<Desc>& map, Desc const& desc) {
+	EXPECT(m_jobs);
+	auto lock = std::scoped_lock(m_mutex);
+	++m_stats.requested;
+	auto [it, inserted] = map.try_emplace(desc);
+	if (!inserted) {
+		++m_stats.shared;
+		return VKPipeline(it->second);
+	}
+	auto entry = it->second = std::make_shared<PipelineEntry>();
+	entry->notReady = &m_notReady;
+	++m_stats.pending;
+	// map nodes are never erased: the key outlives the job
+	auto work = [this, entry, &key = it->first] {
+		DIBS_ZONE("dibs::pipeline_compile");
+		auto const start = Clock::now();
+		try {
+			compile(*entry, key);
+		} catch (std::exception const& e) {
+			warn("Failed to compile pipeline: {}", e.what());
+			finish(*entry, {}, start);
+		}
+	};
+	// detached: a request from an eRecord / eSubmit job must not hold that phase open until the compile finishes
+	m_jobs->push(std::move(work), JobPhase::eAsync, true);
+	return VKPipeline(std::move(entry));
+}
+
+void PipelineService::compile(PipelineEntry& entry, VKPipelineDesc const& desc) {
+	auto const start = Clock::now();
+	auto const fragment = desc.fragment.empty() ? vk::ShaderModule() : shader(desc.fragment);
+	// the pipeline cache is internally synchronized
+	finish(entry, makeGraphicsPipeline(m_device->device, *m_cache, desc, shader(desc.vertex), fragment), start);
+}
+
+void PipelineService::compile(PipelineEntry& entry, VKComputeDesc const& desc) {
+	auto const start = Clock::now();
+	vk::ComputePipelineCreateInfo info({}, {{}, vk::ShaderStageFlagBits::eCompute, shader(desc.shader), "main"}, desc.layout);
+	auto ret = m_device->device.createComputePipelineUnique(*m_cache, info);
+	finish(entry, std::move(ret.value), start);
+}
+
+vk::ShaderModule PipelineService::shader(std::span<std::uint32_t const> const spirv) {
+	auto const key = hash(spirv);
+	auto lock = std::scoped_lock(m_mutex);
+	auto& modules = m_modules[key];
+	for (auto const& cached : modules) {
+		if (std::ranges::equal(cached.spirv, spirv)) {
+			++m_stats.shaderHits;
+			return *cached.module;
+		}
+	}
+	auto created = m_device->device.createShaderModuleUnique({{}, spirv.size_bytes(), spirv.data()});
+	auto const ret = *created;
+	modules.push_back({{spirv.begin(), spirv.end()}, std::move(created)});
+	++m_stats.shaderModules;
+	return ret;
+}
+
+void PipelineService::finish(PipelineEntry& entry, vk::UniquePipeline pipeline, Clock::time_point const start) {
+	auto const ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	auto lock = std::scoped_lock(m_mutex);
+	--m_stats.pending;
+	if (!pipeline) {
+		++m_stats.failed;
+		entry.state.store(PipelineEntry::State::eFailed, std::memory_order_release);
+		return;
+	}
+	entry.pipeline = *pipeline;
+	m_pipelines.push_back(std::move(pipeline));
+	++m_stats.compiled;
+	m_totalMs += ms;
+	m_stats.meanCompileMs = static_cast<float>(m_totalMs / double(m_stats.compiled));
+	m_stats.maxCompileMs = std::max(m_stats.maxCompileMs, static_cast<float>(ms));
+	entry.state.store(PipelineEntry::State::eReady, std::memory_order_release);
+}
+} // namespace dibs::detail
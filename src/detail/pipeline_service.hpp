@@ -0,0 +1,76 @@
+#pragma once
+#include <dibs/pipelines.hpp>
+#include <dibs/stats.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+
+namespace dibs::detail {
+class JobSystem;
+
+struct PipelineEntry {
+	enum class State : std::uint8_t { ePending, eReady, eFailed };
+
+	std::atomic<State> state{State::ePending};
+	vk::Pipeline pipeline; // written before state is released
+	std::atomic<std::uint64_t>* notReady{};
+};
+
+struct PipelineHash {
+	std::size_t operator()(VKPipelineDesc const& desc) const noexcept;
+	std::size_t operator()(VKComputeDesc const& desc) const noexcept;
+};
+
+// viewport and scissor are dynamic; desc.vertex / fragment are unused (fragment may be null: depth only)
+vk::UniquePipeline makeGraphicsPipeline(vk::Device device, vk::PipelineCache cache, VKPipelineDesc const& desc, vk::ShaderModule vertex, vk::ShaderModule fragment);
+
+// compiles pipelines on job workers (JobPhase::eAsync); owns every pipeline and shader module it creates
+class PipelineService {
+  public:
+	using Clock = std::chrono::steady_clock;
+
+	PipelineService() = default;
+	PipelineService(PipelineService&&) = delete;
+	PipelineService& operator=(PipelineService&&) = delete;
+
+	// device and jobs must outlive this, and jobs must be stopped before it is destroyed
+	void init(VKDevice const& device, JobSystem& jobs);
+
+	VKPipeline request(VKPipelineDesc const& desc);
+	VKPipeline request(VKComputeDesc const& desc);
+
+	// counters, and whether any pipeline was used before it was ready since the previous call
+	void sample(PipelineCompileStats& out);
+
+  private:
+	struct Module {
+		std::vector<std::uint32_t> spirv;
+		vk::UniqueShaderModule module;
+	};
+
+	template <typename Desc>
+	using Map = std::unordered_map<Desc, std::shared_ptr<PipelineEntry>, PipelineHash>;
+
+	template <typename Desc>
+	VKPipeline request(Map<Desc>& map, Desc const& desc);
+	void compile(PipelineEntry& entry, VKPipelineDesc const& desc);
+	void compile(PipelineEntry& entry, VKComputeDesc const& desc);
+	vk::ShaderModule shader(std::span<std::uint32_t const> spirv);
+	void finish(PipelineEntry& entry, vk::UniquePipeline pipeline, Clock::time_point start);
+
+	VKDevice const* m_device{};
+	JobSystem* m_jobs{};
+	vk::UniquePipelineCache m_cache;
+	std::mutex m_mutex; // everything below except the counters
+	Map<VKPipelineDesc> m_graphics;
+	Map<VKComputeDesc> m_compute;
+	std::unordered_map<std::uint64_t, std::vector<Module>> m_modules; // by SPIR-V hash
+	std::vector<vk::UniquePipeline> m_pipelines;
+	PipelineCompileStats m_stats;
+	double m_totalMs{};
+	std::atomic<std::uint64_t> m_notReady{};
+	std::uint64_t m_sampledNotReady{};
+};
+} // namespace dibs::detail
@@ -0,0 +1,326 @@
+#include <detail/pixel_kernels.hpp>
+#include <array>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__))
+#define DIBS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define DIBS_AVX2
+#else
+#define DIBS_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DIBS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace dibs::detail {
+namespace {
+// sRGB decode for colour channels [0, 256), linear alpha [256, 512)
+std::array<float, 512> const& decodeTable() noexcept {
+	static auto const s_table = [] {
+		auto ret = std::array<float, 512>{};
+		for (std::size_t i = 0; i < 256U; ++i) {
+			auto const c = static_cast<float>(i) / 255.0f;
+			ret[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			ret[256U + i] = c;
+		}
+		return ret;
+	}();
+	return s_table;
+}
+
+// exact round(c * a / 255)
+constexpr std::uint8_t mulDiv255(std::uint32_t const c, std::uint32_t const a) noexcept {
+	auto const t = c * a + 128U;
+	return static_cast<std::uint8_t>((t + (t >> 8U)) >> 8U);
+}
+
+namespace scalar {
+void swizzle(std::uint8_t const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	for (std::size_t i = 0; i < count; ++i, src += 4, dst += 4) {
+		std::uint8_t const p[] = {src[2], src[1], src[0], src[3]};
+		for (int c = 0; c < 4; ++c) { dst[c] = p[c]; }
+	}
+}
+
+void pack(float const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	for (std::size_t i = 0; i < count; ++i) {
+		auto const v = src[i] > 0.0f ? (src[i] < 1.0f ? src[i] : 1.0f) : 0.0f; // also maps NaN to 0
+		dst[i] = static_cast<std::uint8_t>(std::lrint(v * 255.0f));
+	}
+}
+
+void srgbToLinear(std::uint8_t const* src, float* dst, std::size_t const count) noexcept {
+	auto const& table = decodeTable();
+	for (std::size_t i = 0; i < count; ++i, src += 4, dst += 4) {
+		for (int c = 0; c < 3; ++c) { dst[c] = table[src[c]]; }
+		dst[3] = table[256U + src[3]];
+	}
+}
+
+void premultiply(std::uint8_t const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	for (std::size_t i = 0; i < count; ++i, src += 4, dst += 4) {
+		auto const a = src[3];
+		for (int c = 0; c < 3; ++c) { dst[c] = mulDiv255(src[c], a); }
+		dst[3] = a;
+	}
+}
+
+void downscaleRow(std::uint8_t const* row0, std::uint8_t const* row1, std::uint8_t* dst, std::size_t const count) noexcept {
+	for (std::size_t i = 0; i < count; ++i, row0 += 8, row1 += 8, dst += 4) {
+		for (int c = 0; c < 4; ++c) {
+			auto const sum = std::uint32_t(row0[c]) + row0[c + 4] + row1[c] + row1[c + 4] + 2U;
+			dst[c] = static_cast<std::uint8_t>(sum >> 2U);
+		}
+	}
+}
+} // namespace scalar
+
+#if defined(DIBS_X86)
+namespace sse2 {
+void swizzle(std::uint8_t const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	// no byte shuffle before SSSE3: swap bytes 0 and 2 of each little-endian dword with shifts
+	auto const ga = _mm_set1_epi32(static_cast<int>(0xff00ff00U));
+	auto const lo = _mm_set1_epi32(0xff);
+	std::size_t i = 0;
+	for (; i + 4U <= count; i += 4U) {
+		auto const p = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * 4U));
+		auto const rb = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), lo), _mm_slli_epi32(_mm_and_si128(p, lo), 16));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4U), _mm_or_si128(_mm_and_si128(p, ga), rb));
+	}
+	scalar::swizzle(src + i * 4U, dst + i * 4U, count - i);
+}
+
+void pack(float const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	auto const zero = _mm_setzero_ps();
+	auto const one = _mm_set1_ps(1.0f);
+	auto const scale = _mm_set1_ps(255.0f);
+	auto const load = [&](float const* in) {
+		// max(x, 0) returns 0 for NaN
+		auto const v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in), zero), one);
+		return _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+	};
+	std::size_t i = 0;
+	for (; i + 16U <= count; i += 16U) {
+		auto const a = _mm_packs_epi32(load(src + i), load(src + i + 4U));
+		auto const b = _mm_packs_epi32(load(src + i + 8U), load(src + i + 12U));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+	}
+	scalar::pack(src + i, dst + i, count - i);
+}
+
+void premultiply(std::uint8_t const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	auto const zero = _mm_setzero_si128();
+	auto const round = _mm_set1_epi16(128);
+	auto const alpha = _mm_set1_epi32(static_cast<int>(0xff000000U));
+	auto const mul = [&](__m128i const c) {
+		// broadcast each pixel's alpha across its 4 words
+		auto const a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		auto const t = _mm_add_epi16(_mm_mullo_epi16(c, a), round);
+		return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+	};
+	std::size_t i = 0;
+	for (; i + 4U <= count; i += 4U) {
+		auto const p = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * 4U));
+		auto const rgb = _mm_packus_epi16(mul(_mm_unpacklo_epi8(p, zero)), mul(_mm_unpackhi_epi8(p, zero)));
+		auto const out = _mm_or_si128(_mm_andnot_si128(alpha, rgb), _mm_and_si128(p, alpha));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4U), out);
+	}
+	scalar::premultiply(src + i * 4U, dst + i * 4U, count - i);
+}
+
+void downscaleRow(std::uint8_t const* row0, std::uint8_t const* row1, std::uint8_t* dst, std::size_t const count) noexcept {
+	auto const zero = _mm_setzero_si128();
+	auto const round = _mm_set1_epi16(2);
+	std::size_t i = 0;
+	for (; i + 2U <= count; i += 2U) {
+		auto const a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row0 + i * 8U));
+		auto const b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(row1 + i * 8U));
+		// vertical sums of source pixels [0, 1] and [2, 3] (words)
+		auto const lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+		auto const hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+		// horizontal sums in the low halves
+		auto const sumLo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+		auto const sumHi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+		auto const avg = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sumLo, sumHi), round), 2);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 4U), _mm_packus_epi16(avg, zero));
+	}
+	scalar::downscaleRow(row0 + i * 8U, row1 + i * 8U, dst + i * 4U, count - i);
+}
+} // namespace sse2
+
+namespace avx2 {
+DIBS_AVX2 void swizzle(std::uint8_t const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	auto const mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+	std::size_t i = 0;
+	for (; i + 8U <= count; i += 8U) {
+		auto const p = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i * 4U));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4U), _mm256_shuffle_epi8(p, mask));
+	}
+	sse2::swizzle(src + i * 4U, dst + i * 4U, count - i);
+}
+
+// (lambdas do not inherit the target attribute)
+DIBS_AVX2 inline __m256i toUnorm(float const* in) noexcept {
+	auto const v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+	return _mm256_cvtps_epi32(_mm256_mul_ps(v, _mm256_set1_ps(255.0f)));
+}
+
+DIBS_AVX2 inline __m256i mulAlpha(__m256i const c) noexcept {
+	auto const a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	auto const t = _mm256_add_epi16(_mm256_mullo_epi16(c, a), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+DIBS_AVX2 void pack(float const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	// packs interleave 128-bit lanes: restore source order
+	auto const order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	std::size_t i = 0;
+	for (; i + 32U <= count; i += 32U) {
+		auto const a = _mm256_packs_epi32(toUnorm(src + i), toUnorm(src + i + 8U));
+		auto const b = _mm256_packs_epi32(toUnorm(src + i + 16U), toUnorm(src + i + 24U));
+		auto const bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(a, b), order);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), bytes);
+	}
+	sse2::pack(src + i, dst + i, count - i);
+}
+
+DIBS_AVX2 void srgbToLinear(std::uint8_t const* src, float* dst, std::size_t const count) noexcept {
+	auto const* table = decodeTable().data();
+	// alpha indexes the linear half of the table
+	auto const offset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+	std::size_t i = 0;
+	for (; i + 2U <= count; i += 2U) {
+		auto const bytes = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(src + i * 4U));
+		auto const index = _mm256_add_epi32(_mm256_cvtepu8_epi32(bytes), offset);
+		_mm256_storeu_ps(dst + i * 4U, _mm256_i32gather_ps(table, index, 4));
+	}
+	scalar::srgbToLinear(src + i * 4U, dst + i * 4U, count - i);
+}
+
+DIBS_AVX2 void premultiply(std::uint8_t const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	auto const zero = _mm256_setzero_si256();
+	auto const alpha = _mm256_set1_epi32(static_cast<int>(0xff000000U));
+	std::size_t i = 0;
+	for (; i + 8U <= count; i += 8U) {
+		// unpack / pack stay within 128-bit lanes: pixel order is preserved
+		auto const p = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i * 4U));
+		auto const rgb = _mm256_packus_epi16(mulAlpha(_mm256_unpacklo_epi8(p, zero)), mulAlpha(_mm256_unpackhi_epi8(p, zero)));
+		auto const out = _mm256_or_si256(_mm256_andnot_si256(alpha, rgb), _mm256_and_si256(p, alpha));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4U), out);
+	}
+	sse2::premultiply(src + i * 4U, dst + i * 4U, count - i);
+}
+} // namespace avx2
+
+bool cpuHasAvx2() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4]{};
+	__cpuid(info, 0);
+	if (info[0] < 7) { return false; }
+	__cpuid(info, 1);
+	bool const osxsave = (info[2] & (1 << 27)) != 0;
+	if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) { return false; } // OS must save ymm state
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+#if defined(DIBS_NEON)
+namespace neon {
+void swizzle(std::uint8_t const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	std::size_t i = 0;
+	for (; i + 16U <= count; i += 16U) {
+		auto p = vld4q_u8(src + i * 4U);
+		auto const r = p.val[0];
+		p.val[0] = p.val[2];
+		p.val[2] = r;
+		vst4q_u8(dst + i * 4U, p);
+	}
+	scalar::swizzle(src + i * 4U, dst + i * 4U, count - i);
+}
+
+void pack(float const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	auto const zero = vdupq_n_f32(0.0f);
+	auto const one = vdupq_n_f32(1.0f);
+	auto const load = [&](float const* in) {
+		// vmaxq propagates NaN: select instead, mapping it to 0 as on x86
+		auto const v = vld1q_f32(in);
+		auto const clamped = vminq_f32(vbslq_f32(vcgtq_f32(v, zero), v, zero), one);
+		return vqmovn_u32(vcvtnq_u32_f32(vmulq_n_f32(clamped, 255.0f)));
+	};
+	std::size_t i = 0;
+	for (; i + 16U <= count; i += 16U) {
+		auto const a = vcombine_u16(load(src + i), load(src + i + 4U));
+		auto const b = vcombine_u16(load(src + i + 8U), load(src + i + 12U));
+		vst1q_u8(dst + i, vcombine_u8(vqmovn_u16(a), vqmovn_u16(b)));
+	}
+	scalar::pack(src + i, dst + i, count - i);
+}
+
+void premultiply(std::uint8_t const* src, std::uint8_t* dst, std::size_t const count) noexcept {
+	// (x + ((x + 128) >> 8) + 128) >> 8: same rounding as mulDiv255
+	auto const mul = [](uint8x16_t const c, uint8x16_t const a) {
+		auto const lo = vmull_u8(vget_low_u8(c), vget_low_u8(a));
+		auto const hi = vmull_u8(vget_high_u8(c), vget_high_u8(a));
+		return vcombine_u8(vrshrn_n_u16(vrsraq_n_u16(lo, lo, 8), 8), vrshrn_n_u16(vrsraq_n_u16(hi, hi, 8), 8));
+	};
+	std::size_t i = 0;
+	for (; i + 16U <= count; i += 16U) {
+		auto p = vld4q_u8(src + i * 4U);
+		for (int c = 0; c < 3; ++c) { p.val[c] = mul(p.val[c], p.val[3]); }
+		vst4q_u8(dst + i * 4U, p);
+	}
+	scalar::premultiply(src + i * 4U, dst + i * 4U, count - i);
+}
+
+void downscaleRow(std::uint8_t const* row0, std::uint8_t const* row1, std::uint8_t* dst, std::size_t const count) noexcept {
+	std::size_t i = 0;
+	for (; i + 8U <= count; i += 8U) {
+		auto const a = vld4q_u8(row0 + i * 8U);
+		auto const b = vld4q_u8(row1 + i * 8U);
+		uint8x8x4_t out;
+		for (int c = 0; c < 4; ++c) {
+			// pairwise (horizontal) widening add, accumulate the second row, rounding shift
+			out.val[c] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(a.val[c]), b.val[c]), 2);
+		}
+		vst4_u8(dst + i * 4U, out);
+	}
+	scalar::downscaleRow(row0 + i * 8U, row1 + i * 8U, dst + i * 4U, count - i);
+}
+} // namespace neon
+#endif
+} // namespace
+
+SimdLevel detectSimd() noexcept {
+#if defined(DIBS_X86)
+	return cpuHasAvx2() ? SimdLevel::eAvx2 : SimdLevel::eSse2;
+#elif defined(DIBS_NEON)
+	return SimdLevel::eNeon;
+#else
+	return SimdLevel::eScalar;
+#endif
+}
+
+PixelKernels pixelKernels(SimdLevel const level) noexcept {
+	switch (level) {
+#if defined(DIBS_X86)
+	// table lookups gain little without a gather: sse2 uses the scalar path
+	case SimdLevel::eSse2: return {&sse2::swizzle, &sse2::pack, &scalar::srgbToLinear, &sse2::premultiply, &sse2::downscaleRow};
+	// downscale is load bound at 128 bits
+	case SimdLevel::eAvx2: return {&avx2::swizzle, &avx2::pack, &avx2::srgbToLinear, &avx2::premultiply, &sse2::downscaleRow};
+#endif
+#if defined(DIBS_NEON)
+	case SimdLevel::eNeon: return {&neon::swizzle, &neon::pack, &scalar::srgbToLinear, &neon::premultiply, &neon::downscaleRow};
+#endif
+	default: return {&scalar::swizzle, &scalar::pack, &scalar::srgbToLinear, &scalar::premultiply, &scalar::downscaleRow};
+	}
+}
+} // namespace dibs::detail
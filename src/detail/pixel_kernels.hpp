@@ -0,0 +1,21 @@
+#pragma once
+#include <dibs/pixels.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace dibs::detail {
+// counts are in pixels (4 bytes), except pack (floats)
+struct PixelKernels {
+	void (*swizzle)(std::uint8_t const* src, std::uint8_t* dst, std::size_t count){};
+	void (*pack)(float const* src, std::uint8_t* dst, std::size_t count){};
+	void (*srgbToLinear)(std::uint8_t const* src, float* dst, std::size_t count){};
+	void (*premultiply)(std::uint8_t const* src, std::uint8_t* dst, std::size_t count){};
+	// averages 2x2 blocks of two source rows into count destination pixels
+	void (*downscaleRow)(std::uint8_t const* row0, std::uint8_t const* row1, std::uint8_t* dst, std::size_t count){};
+};
+
+// best level supported by this CPU (and build)
+SimdLevel detectSimd() noexcept;
+// kernels for level; must be supported
+PixelKernels pixelKernels(SimdLevel level) noexcept;
+} // namespace dibs::detail
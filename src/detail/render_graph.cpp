@@ -0,0 +1,419 @@
+#include <detail/defer_queue.hpp>
+#include <detail/expect.hpp>
+#include <detail/log.hpp>
+#include <detail/render_graph.hpp>
+#include <detail/vk_memory.hpp>
+#include <algorithm>
+
+namespace dibs::detail {
+namespace {
+using Use = FrameGraph::Use;
+using PSFB2 = vk::PipelineStageFlagBits2;
+using AFB2 = vk::AccessFlagBits2;
+
+constexpr vk::AccessFlags2 write_mask_v = AFB2::eColorAttachmentWrite | AFB2::eDepthStencilAttachmentWrite | AFB2::eShaderWrite | AFB2::eTransferWrite;
+
+struct UseInfo {
+	vk::ImageLayout layout{};
+	vk::PipelineStageFlags2 stages;
+	vk::AccessFlags2 access;
+	vk::ImageUsageFlags usage;
+	bool write{};
+};
+
+constexpr UseInfo useInfo(Use const use) noexcept {
+	using Layout = vk::ImageLayout;
+	using IUFB = vk::ImageUsageFlagBits;
+	constexpr auto shader_v = PSFB2::eFragmentShader | PSFB2::eComputeShader;
+	switch (use) {
+	case Use::eColourAttachment:
+		return {Layout::eColorAttachmentOptimal, PSFB2::eColorAttachmentOutput, AFB2::eColorAttachmentRead | AFB2::eColorAttachmentWrite, IUFB::eColorAttachment,
+				true};
+	case Use::eDepthAttachment:
+		return {Layout::eDepthStencilAttachmentOptimal, PSFB2::eEarlyFragmentTests | PSFB2::eLateFragmentTests,
+				AFB2::eDepthStencilAttachmentRead | AFB2::eDepthStencilAttachmentWrite, IUFB::eDepthStencilAttachment, true};
+	case Use::eSampled: return {Layout::eShaderReadOnlyOptimal, shader_v, AFB2::eShaderRead, IUFB::eSampled, false};
+	case Use::eStorageRead: return {Layout::eGeneral, shader_v, AFB2::eShaderRead, IUFB::eStorage, false};
+	case Use::eStorageWrite: return {Layout::eGeneral, shader_v, AFB2::eShaderRead | AFB2::eShaderWrite, IUFB::eStorage, true};
+	case Use::eTransferSrc: return {Layout::eTransferSrcOptimal, PSFB2::eTransfer, AFB2::eTransferRead, IUFB::eTransferSrc, false};
+	case Use::eTransferDst: return {Layout::eTransferDstOptimal, PSFB2::eTransfer, AFB2::eTransferWrite, IUFB::eTransferDst, true};
+	}
+	return {};
+}
+
+constexpr vk::ImageAspectFlags aspect(vk::Format const format) noexcept {
+	switch (format) {
+	case vk::Format::eD16Unorm:
+	case vk::Format::eX8D24UnormPack32:
+	case vk::Format::eD32Sfloat: return vk::ImageAspectFlagBits::eDepth;
+	case vk::Format::eD16UnormS8Uint:
+	case vk::Format::eD24UnormS8Uint:
+	case vk::Format::eD32SfloatS8Uint: return vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil;
+	case vk::Format::eS8Uint: return vk::ImageAspectFlagBits::eStencil;
+	default: return vk::ImageAspectFlagBits::eColor;
+	}
+}
+
+// legacy stage / access bits share values with their synchronization2 counterparts
+vk::PipelineStageFlags legacy(vk::PipelineStageFlags2 const stages) noexcept {
+	return vk::PipelineStageFlags(static_cast<VkPipelineStageFlags>(static_cast<VkPipelineStageFlags2>(stages)));
+}
+
+vk::AccessFlags legacy(vk::AccessFlags2 const access) noexcept {
+	return vk::AccessFlags(static_cast<VkAccessFlags>(static_cast<VkAccessFlags2>(access)));
+}
+
+vk::UniqueImageView makeView(vk::Device const device, vk::Image const image, vk::Format const format) {
+	vk::ImageViewCreateInfo info;
+	info.viewType = vk::ImageViewType::e2D;
+	info.format = format;
+	info.subresourceRange = {aspect(format), 0, 1, 0, 1};
+	info.image = image;
+	return device.createImageViewUnique(info);
+}
+} // namespace
+
+void RenderGraph::begin(Target const& backbuffer, std::optional<Scene> scene) {
+	m_sceneDesc = scene;
+	m_scene = 0U;
+	m_resources.clear();
+	m_resources.push_back({});
+	m_resources.front().target = backbuffer;
+	for (std::size_t i = 0; i < m_passCount; ++i) { m_passes[i].record = {}; }
+	m_passCount = 0;
+}
+
+FrameGraph::Image RenderGraph::transient(Transient const& desc) {
+	m_resources.push_back({});
+	m_resources.back().desc = desc;
+	return {std::uint32_t(m_resources.size() - 1U)};
+}
+
+FrameGraph::Image RenderGraph::scene() {
+	if (!m_sceneDesc) { return {}; }
+	if (m_scene == 0U) {
+		// extent is zero: allocated at frame extent, so render scale changes never reallocate
+		m_scene = transient({m_sceneDesc->format, {}}).index;
+		m_resources.back().scaled = true;
+	}
+	return {m_scene};
+}
+
+std::optional<FrameGraph::Image> RenderGraph::writtenScene() const noexcept {
+	if (m_scene == 0U || !written({m_scene})) { return std::nullopt; }
+	return Image{m_scene};
+}
+
+void RenderGraph::pass(std::string name, std::span<Access const> accesses, Record record) {
+	if (m_passCount == m_passes.size()) { m_passes.emplace_back(); }
+	auto& pass = m_passes[m_passCount++];
+	pass.name = std::move(name);
+	pass.accesses.assign(accesses.begin(), accesses.end());
+	pass.record = std::move(record);
+	for (auto const& access : accesses) {
+		EXPECT(access.image.index < m_resources.size());
+		m_resources[access.image.index].usage |= useInfo(access.use).usage;
+	}
+}
+
+bool RenderGraph::written(Image const image) const noexcept {
+	for (std::size_t i = 0; i < m_passCount; ++i) {
+		for (auto const& access : m_passes[i].accesses) {
+			if (access.image == image && useInfo(access.use).write) { return true; }
+		}
+	}
+	return false;
+}
+
+RenderGraph::Target const& RenderGraph::target(Image const image) const noexcept {
+	EXPECT(image.index < m_resources.size());
+	return m_resources[image.index].target;
+}
+
+vk::PipelineStageFlags RenderGraph::record(VKDevice const& device, vk::CommandBuffer const cb, vk::ImageLayout const final, DeferQueue& deferQueue) {
+	schedule();
+	// passes using a transient without memory are skipped (with their barriers)
+	bool const complete = realize(device, deferQueue);
+	bool const sync2 = device.features.test(VKFeature::eSynchronization2);
+	Stages wait;
+	// all barriers required by a level are merged into one call, then its (mutually independent) passes are recorded
+	for (std::size_t i = 0; i < m_order.size();) {
+		auto const level = m_passes[m_order[i]].level;
+		auto end = i;
+		for (; end < m_order.size() && m_passes[m_order[end]].level == level; ++end) {
+			auto const& pass = m_passes[m_order[end]];
+			if (!complete && !realized(pass)) { continue; }
+			for (auto const& access : pass.accesses) { barrier(access, wait); }
+		}
+		emit(cb, sync2);
+		for (; i < end; ++i) {
+			auto& pass = m_passes[m_order[i]];
+			if (complete || realized(pass)) { pass.record(FrameGraph::Context(*this, cb)); }
+			pass.record = {};
+		}
+	}
+	// transition backbuffer to final layout
+	auto& back = m_resources.front();
+	if (back.state.layout != final) {
+		vk::ImageMemoryBarrier2 ib;
+		ib.oldLayout = back.state.layout;
+		ib.newLayout = final;
+		if (back.state.layout == vk::ImageLayout::eUndefined) {
+			ib.srcStageMask = wait = PSFB2::eColorAttachmentOutput;
+		} else {
+			ib.srcStageMask = back.state.writeStages | back.state.readStages;
+			ib.srcAccessMask = back.state.writeAccess;
+		}
+		ib.srcQueueFamilyIndex = ib.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		ib.image = back.target.image;
+		ib.subresourceRange = {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
+		m_barriers.push_back(ib);
+		emit(cb, sync2);
+	}
+	auto const ret = legacy(wait);
+	return ret ? ret : vk::PipelineStageFlagBits::eTopOfPipe;
+}
+
+void RenderGraph::schedule() {
+	// a pass is placed one level after every pass it has a hazard with (in declaration order);
+	// passes sharing a level are independent and can share a single barrier batch
+	for (std::size_t i = 0; i < m_passCount; ++i) {
+		auto& pass = m_passes[i];
+		std::uint32_t level{};
+		for (auto const& access : pass.accesses) {
+			auto const& resource = m_resources[access.image.index];
+			auto const use = useInfo(access.use);
+			if (resource.writeLevel >= 0) { level = std::max(level, std::uint32_t(resource.writeLevel + 1)); }
+			if ((use.write || resource.levelLayout != use.layout) && resource.readLevel >= 0) {
+				level = std::max(level, std::uint32_t(resource.readLevel + 1));
+			}
+		}
+		pass.level = level;
+		for (auto const& access : pass.accesses) {
+			auto& resource = m_resources[access.image.index];
+			auto const use = useInfo(access.use);
+			if (use.write) {
+				resource.writeLevel = std::int64_t(level);
+			} else {
+				resource.readLevel = std::max(resource.readLevel, std::int64_t(level));
+			}
+			resource.levelLayout = use.layout;
+			resource.first = std::min(resource.first, level);
+			resource.last = std::max(resource.last, level);
+			resource.used = true;
+		}
+	}
+	m_order.clear();
+	for (std::size_t i = 0; i < m_passCount; ++i) { m_order.push_back(i); }
+	std::stable_sort(m_order.begin(), m_order.end(), [this](std::size_t a, std::size_t b) { return m_passes[a].level < m_passes[b].level; });
+}
+
+bool RenderGraph::realized(Pass const& pass) const noexcept {
+	auto const bound = [this](Access const& access) { return access.image.index == 0U || m_resources[access.image.index].target.view; };
+	return std::all_of(pass.accesses.begin(), pass.accesses.end(), bound);
+}
+
+bool RenderGraph::realize(VKDevice const& device, DeferQueue& deferQueue) {
+	auto const frame = m_resources.front().target.extent;
+	m_key.clear();
+	for (std::size_t i = 1; i < m_resources.size(); ++i) {
+		auto& resource = m_resources[i];
+		auto const& desc = resource.desc;
+		resource.target.extent = desc.extent.x == 0U || desc.extent.y == 0U ? frame : vk::Extent2D(desc.extent.x, desc.extent.y);
+		if (resource.used) {
+			m_key.push_back({desc.format, resource.target.extent, resource.usage, resource.first, resource.last});
+		} else {
+			m_key.push_back({});
+		}
+	}
+	if (m_key != m_cachedKey) {
+		// lifetimes / descriptions changed: retire current allocation and alias a new one
+		deferQueue.defer(std::move(m_allocation), m_allocated);
+		m_allocation = {};
+		m_allocated = 0U;
+		m_complete = true;
+		m_blocks.clear();
+		for (std::size_t i = 1; i < m_resources.size(); ++i) {
+			auto const& resource = m_resources[i];
+			if (!resource.used) {
+				m_allocation.images.push_back({});
+				continue;
+			}
+			vk::ImageCreateInfo info;
+			info.imageType = vk::ImageType::e2D;
+			info.format = resource.desc.format;
+			info.extent = vk::Extent3D(resource.target.extent, 1U);
+			info.mipLevels = info.arrayLayers = 1U;
+			info.samples = vk::SampleCountFlagBits::e1;
+			info.tiling = vk::ImageTiling::eOptimal;
+			info.usage = resource.usage;
+			info.initialLayout = vk::ImageLayout::eUndefined;
+			m_allocation.images.push_back(device.device.createImageUnique(info));
+		}
+		// greedily place each transient (in order of first use) in a block whose previous occupant's lifetime has ended
+		std::vector<std::size_t> order;
+		for (std::size_t i = 1; i < m_resources.size(); ++i) {
+			if (m_resources[i].used) { order.push_back(i); }
+		}
+		std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) { return m_resources[a].first < m_resources[b].first; });
+		m_allocation.blocks.assign(m_resources.size(), 0U);
+		for (auto const index : order) {
+			auto const& resource = m_resources[index];
+			auto const mr = device.device.getImageMemoryRequirements(*m_allocation.images[index - 1U]);
+			auto const fits = [&](Block const& block) { return block.last < resource.first && (block.requirements.memoryTypeBits & mr.memoryTypeBits); };
+			auto it = std::find_if(m_blocks.begin(), m_blocks.end(), fits);
+			if (it == m_blocks.end()) {
+				m_blocks.push_back({{}, {}, mr, resource.last});
+				it = m_blocks.end() - 1;
+			} else {
+				it->requirements.size = std::max(it->requirements.size, mr.size);
+				it->requirements.alignment = std::max(it->requirements.alignment, mr.alignment);
+				it->requirements.memoryTypeBits &= mr.memoryTypeBits;
+				it->last = resource.last;
+			}
+			m_allocation.blocks[index] = std::size_t(it - m_blocks.begin());
+		}
+		for (auto const& block : m_blocks) {
+			m_allocation.memory.push_back(allocate(device.device, device.gpu.memory, block.requirements, vk::MemoryPropertyFlagBits::eDeviceLocal));
+			if (!m_allocation.memory.back()) {
+				m_complete = false;
+				continue;
+			}
+			m_allocated += block.requirements.size;
+		}
+		// not retried until the key changes
+		if (!m_complete) { warn("Frame graph: failed to allocate transient memory, skipping the passes that use it"); }
+		for (std::size_t i = 1; i < m_resources.size(); ++i) {
+			auto const& image = m_allocation.images[i - 1U];
+			// an image without memory gets no view
+			if (!image || !m_allocation.memory[m_allocation.blocks[i]]) {
+				m_allocation.views.push_back({});
+				continue;
+			}
+			device.device.bindImageMemory(*image, *m_allocation.memory[m_allocation.blocks[i]], 0U);
+			m_allocation.views.push_back(makeView(device.device, *image, m_resources[i].desc.format));
+		}
+		m_cachedKey = m_key;
+	}
+	// stages touching each block (across all occupants) guard the first use of any occupant
+	m_blocks.resize(m_allocation.memory.size());
+	for (auto& block : m_blocks) {
+		block.stages = {};
+		block.writes = {};
+	}
+	for (std::size_t i = 1; i < m_resources.size(); ++i) {
+		auto& resource = m_resources[i];
+		if (!resource.used) { continue; }
+		resource.block = m_allocation.blocks[i];
+		resource.target.image = *m_allocation.images[i - 1U];
+		resource.target.view = *m_allocation.views[i - 1U];
+		if (resource.scaled && m_sceneDesc) {
+			// passes render into (and the upscale reads from) the top-left region
+			auto const scale = std::clamp(m_sceneDesc->scale, 0.0f, 1.0f);
+			resource.target.extent.width = std::max(std::uint32_t(float(frame.width) * scale + 0.5f), 1U);
+			resource.target.extent.height = std::max(std::uint32_t(float(frame.height) * scale + 0.5f), 1U);
+		}
+	}
+	for (std::size_t i = 0; i < m_passCount; ++i) {
+		for (auto const& access : m_passes[i].accesses) {
+			if (access.image.index == 0U) { continue; }
+			auto const use = useInfo(access.use);
+			auto& block = m_blocks[m_resources[access.image.index].block];
+			block.stages |= use.stages;
+			block.writes |= use.access & write_mask_v;
+		}
+	}
+	return m_complete;
+}
+
+void RenderGraph::barrier(Access const& access, Stages& wait) {
+	auto& resource = m_resources[access.image.index];
+	auto& state = resource.state;
+	auto const use = useInfo(access.use);
+	vk::ImageMemoryBarrier2 ib;
+	ib.oldLayout = state.layout;
+	ib.newLayout = use.layout;
+	ib.dstStageMask = use.stages;
+	ib.dstAccessMask = use.access;
+	if (state.layout == vk::ImageLayout::eUndefined) {
+		if (access.image.index == 0U) {
+			// chain with the acquire semaphore wait
+			ib.srcStageMask = use.stages;
+			if (!wait) { wait = use.stages; }
+		} else {
+			// previous occupant of aliased memory (this or last frame)
+			auto const& block = m_blocks[resource.block];
+			ib.srcStageMask = block.stages;
+			ib.srcAccessMask = block.writes;
+		}
+	} else if (use.write || state.layout != use.layout) {
+		// write-after-write, write-after-read, or layout transition
+		ib.srcStageMask = state.writeStages | state.readStages;
+		ib.srcAccessMask = state.writeAccess;
+	} else {
+		// read-after-write in the same layout: only stages not yet synchronized need a barrier
+		auto const missing = use.stages & ~state.visible;
+		state.readStages |= use.stages;
+		if (!missing) { return; }
+		ib.srcStageMask = state.writeStages;
+		ib.srcAccessMask = state.writeAccess;
+		ib.dstStageMask = missing;
+		state.visible |= missing;
+		push(resource, ib);
+		return;
+	}
+	state.layout = use.layout;
+	state.writeStages = use.stages;
+	state.writeAccess = use.access & write_mask_v;
+	state.readStages = use.write ? Stages{} : use.stages;
+	state.visible = use.stages;
+	push(resource, ib);
+}
+
+void RenderGraph::push(Resource const& resource, vk::ImageMemoryBarrier2 ib) {
+	auto const same = [image = resource.target.image](vk::ImageMemoryBarrier2 const& b) { return b.image == image; };
+	if (auto it = std::find_if(m_barriers.begin(), m_barriers.end(), same); it != m_barriers.end()) {
+		// independent passes in the same level: layouts match by construction
+		EXPECT(it->newLayout == ib.newLayout);
+		it->srcStageMask |= ib.srcStageMask;
+		it->srcAccessMask |= ib.srcAccessMask;
+		it->dstStageMask |= ib.dstStageMask;
+		it->dstAccessMask |= ib.dstAccessMask;
+		return;
+	}
+	ib.srcQueueFamilyIndex = ib.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	ib.image = resource.target.image;
+	ib.subresourceRange = {aspect(resource.desc.format), 0, 1, 0, 1};
+	m_barriers.push_back(ib);
+}
+
+void RenderGraph::emit(vk::CommandBuffer const cb, bool const sync2) {
+	if (m_barriers.empty()) { return; }
+	if (sync2) {
+		vk::DependencyInfo info;
+		info.imageMemoryBarrierCount = std::uint32_t(m_barriers.size());
+		info.pImageMemoryBarriers = m_barriers.data();
+		cb.pipelineBarrier2(info);
+	} else {
+		m_legacy.clear();
+		vk::PipelineStageFlags src, dst;
+		for (auto const& b : m_barriers) {
+			vk::ImageMemoryBarrier ib;
+			ib.oldLayout = b.oldLayout;
+			ib.newLayout = b.newLayout;
+			ib.srcAccessMask = legacy(b.srcAccessMask);
+			ib.dstAccessMask = legacy(b.dstAccessMask);
+			ib.srcQueueFamilyIndex = ib.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			ib.image = b.image;
+			ib.subresourceRange = b.subresourceRange;
+			m_legacy.push_back(ib);
+			src |= legacy(b.srcStageMask);
+			dst |= legacy(b.dstStageMask);
+		}
+		if (!src) { src = vk::PipelineStageFlagBits::eTopOfPipe; }
+		if (!dst) { dst = vk::PipelineStageFlagBits::eBottomOfPipe; }
+		cb.pipelineBarrier(src, dst, {}, {}, {}, m_legacy);
+	}
+	m_barriers.clear();
+}
+} // namespace dibs::detail
@@ -0,0 +1,126 @@
+#pragma once
+#include <dibs/frame_graph.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dibs::detail {
+class DeferQueue;
+
+class RenderGraph {
+  public:
+	using Image = FrameGraph::Image;
+	using Access = FrameGraph::Access;
+	using Transient = FrameGraph::Transient;
+	using Record = FrameGraph::Record;
+	using Stages = vk::PipelineStageFlags2;
+	using Accesses = vk::AccessFlags2;
+
+	struct Target {
+		vk::Image image;
+		vk::ImageView view;
+		vk::Extent2D extent{};
+	};
+
+	// intermediate colour target rendered at a fraction of the frame extent
+	struct Scene {
+		vk::Format format{};
+		float scale{1.0f};
+	};
+
+	void begin(Target const& backbuffer, std::optional<Scene> scene = {});
+	Image transient(Transient const& desc);
+	// backbuffer if there is no scene target this frame
+	Image scene();
+	// scene target, if one was written this frame
+	std::optional<Image> writtenScene() const noexcept;
+	void pass(std::string name, std::span<Access const> accesses, Record record);
+	bool written(Image image) const noexcept;
+
+	// orders passes, (re)creates transients, records all passes with merged barriers, and transitions the backbuffer to final;
+	// returns the first stage that touches the backbuffer (for the acquire semaphore wait)
+	vk::PipelineStageFlags record(VKDevice const& device, vk::CommandBuffer cb, vk::ImageLayout final, DeferQueue& deferQueue);
+
+	Target const& target(Image image) const noexcept;
+	// device memory bound to transients
+	vk::DeviceSize allocated() const noexcept { return m_allocated; }
+
+  private:
+	struct State {
+		vk::ImageLayout layout{vk::ImageLayout::eUndefined};
+		Stages writeStages;
+		Accesses writeAccess;
+		Stages readStages; // since last write
+		Stages visible;	   // stages synchronized with last write
+	};
+
+	struct Resource {
+		Transient desc;
+		vk::ImageUsageFlags usage;
+		Target target;
+		State state;
+		std::int64_t writeLevel{-1};
+		std::int64_t readLevel{-1};
+		vk::ImageLayout levelLayout{};
+		std::uint32_t first{~0U};
+		std::uint32_t last{};
+		std::size_t block{};
+		bool used{};
+		bool scaled{}; // allocated at frame extent, rendered at scene extent
+	};
+
+	struct Pass {
+		std::string name;
+		std::vector<Access> accesses;
+		Record record;
+		std::uint32_t level{};
+	};
+
+	struct Block {
+		Stages stages;
+		Accesses writes;
+		vk::MemoryRequirements requirements;
+		std::uint32_t last{};
+	};
+
+	struct Key {
+		vk::Format format{};
+		vk::Extent2D extent{};
+		vk::ImageUsageFlags usage;
+		std::uint32_t first{};
+		std::uint32_t last{};
+
+		bool operator==(Key const&) const = default;
+	};
+
+	struct Allocation {
+		std::vector<vk::UniqueDeviceMemory> memory;
+		std::vector<vk::UniqueImage> images;
+		std::vector<vk::UniqueImageView> views;
+		std::vector<std::size_t> blocks; // resource index => memory index
+	};
+
+	void schedule();
+	// false if any transient could not be backed by memory (its view stays null)
+	bool realize(VKDevice const& device, DeferQueue& deferQueue);
+	bool realized(Pass const& pass) const noexcept;
+	void barrier(Access const& access, Stages& wait);
+	void push(Resource const& resource, vk::ImageMemoryBarrier2 ib);
+	void emit(vk::CommandBuffer cb, bool sync2);
+
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+	std::size_t m_passCount{};
+	std::vector<std::size_t> m_order;
+	std::vector<Block> m_blocks;
+	std::vector<vk::ImageMemoryBarrier2> m_barriers;
+	std::vector<vk::ImageMemoryBarrier> m_legacy;
+	std::vector<Key> m_key;
+	std::vector<Key> m_cachedKey;
+	Allocation m_allocation;
+	vk::DeviceSize m_allocated{};
+	bool m_complete{true}; // every block of m_allocation was allocated
+	std::optional<Scene> m_sceneDesc;
+	std::uint32_t m_scene{};
+};
+} // namespace dibs::detail
@@ -0,0 +1,39 @@
+#pragma once
+#include <dibs/dibs.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace dibs::detail {
+// picks a render scale that keeps GPU frame time within budget
+class ResolutionScaler {
+  public:
+	static constexpr float headroom_v = 0.9f; // aim below budget
+	static constexpr float max_step_v = 0.05f;
+	static constexpr float dead_band_v = 0.01f;
+
+	void config(DynamicResolution const& config) noexcept {
+		m_config = config;
+		m_config.minScale = std::clamp(m_config.minScale, 0.1f, 1.0f);
+		m_config.maxScale = std::clamp(m_config.maxScale, m_config.minScale, 1.0f);
+		m_scale = std::clamp(m_scale, m_config.minScale, m_config.maxScale);
+	}
+
+	DynamicResolution const& config() const noexcept { return m_config; }
+	bool enabled() const noexcept { return m_config.budgetMs > 0.0f; }
+	float scale() const noexcept { return enabled() ? m_scale : 1.0f; }
+
+	// GPU time of a completed frame; results lag a couple of frames behind, so steps are bounded
+	void update(float const gpuMs) noexcept {
+		if (!enabled() || gpuMs <= 0.0f) { return; }
+		// GPU time is roughly proportional to pixel count (scale squared)
+		auto const target = m_scale * std::sqrt(m_config.budgetMs * headroom_v / gpuMs);
+		auto const step = std::clamp(target - m_scale, -max_step_v, max_step_v);
+		if (std::abs(step) < dead_band_v) { return; }
+		m_scale = std::clamp(m_scale + step, m_config.minScale, m_config.maxScale);
+	}
+
+  private:
+	DynamicResolution m_config;
+	float m_scale{1.0f};
+};
+} // namespace dibs::detail
@@ -0,0 +1,150 @@
+#include <detail/log.hpp>
+#include <detail/stats_exporter.hpp>
+#include <new>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace dibs::detail {
+namespace {
+using Metric = FrameStats::Metric;
+using Mapping = StatsExporter::Mapping;
+
+#if defined(__linux__) || defined(__APPLE__)
+constexpr bool supported_v = true;
+
+// the object the name refers to now: false if its previous owner unlinked it after it was opened
+bool linked(std::string const& name, int const fd) {
+	auto const current = ::shm_open(name.c_str(), O_RDONLY, 0);
+	if (current < 0) { return false; }
+	struct stat opened {};
+	struct stat named {};
+	bool const ret = ::fstat(fd, &opened) == 0 && ::fstat(current, &named) == 0 && opened.st_dev == named.st_dev && opened.st_ino == named.st_ino;
+	::close(current);
+	return ret;
+}
+
+// the owner holds an exclusive flock on the segment until it is unlinked: a segment that can be locked is new or left by a
+// previous run, and is reused in place (never unlinked from under another process)
+Mapping mapSegment(std::string const& name) {
+	static constexpr int attempts_v = 4;
+	for (int attempt = 0; attempt < attempts_v; ++attempt) {
+		auto const fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0) { return {}; }
+		if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+			if (errno == EWOULDBLOCK) { warn("Stats export: {} is in use by another process", name); }
+			::close(fd);
+			return {};
+		}
+		if (!linked(name, fd)) {
+			::close(fd);
+			continue;
+		}
+		void* ret = nullptr;
+		if (::ftruncate(fd, static_cast<off_t>(sizeof(stats_export::Segment))) == 0) {
+			ret = ::mmap(nullptr, sizeof(stats_export::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (ret == MAP_FAILED) { ret = nullptr; }
+		}
+		if (!ret) {
+			::shm_unlink(name.c_str());
+			::close(fd);
+			return {};
+		}
+		return {ret, fd};
+	}
+	return {};
+}
+
+void unmapSegment(Mapping const& mapping, std::string const& name) {
+	::munmap(mapping.segment, sizeof(stats_export::Segment));
+	// unlinked while still locked: the next run creates a new segment
+	::shm_unlink(name.c_str());
+	::close(mapping.fd);
+}
+
+std::uint32_t processId() { return static_cast<std::uint32_t>(::getpid()); }
+#else
+constexpr bool supported_v = false;
+
+Mapping mapSegment(std::string const&) { return {}; }
+void unmapSegment(Mapping const&, std::string const&) {}
+std::uint32_t processId() { return 0U; }
+#endif
+} // namespace
+
+std::unique_ptr<StatsExporter> StatsExporter::make(std::string name) {
+	if (name.empty()) { return {}; }
+	if constexpr (!supported_v) {
+		warn("Stats export is not supported on this platform");
+		return {};
+	}
+	if (name.front() != '/') { name.insert(name.begin(), '/'); }
+	auto const mapping = mapSegment(name);
+	if (!mapping.segment) {
+		warn("Stats export: failed to create shared memory segment {}", name);
+		return {};
+	}
+	auto ret = std::make_unique<StatsExporter>();
+	ret->m_mapping = mapping;
+	ret->m_segment = new (mapping.segment) stats_export::Segment{};
+	ret->m_segment->size = static_cast<std::uint32_t>(sizeof(stats_export::Segment));
+	ret->m_segment->pid = processId();
+	ret->m_name = std::move(name);
+	log("Stats export: publishing to shared memory {}", ret->m_name);
+	return ret;
+}
+
+StatsExporter::~StatsExporter() {
+	if (m_segment) {
+		// readers keep their mapping; the name is released for the next run
+		unmapSegment(m_mapping, m_name);
+	}
+}
+
+void StatsExporter::publish(Stats const& stats, std::uint64_t const recreations, std::size_t const events, std::uint64_t const timeNs) noexcept {
+	auto const& frames = stats.frames;
+	m_events += events;
+	// gathered before the write section, keeping it short
+	stats_export::Values values;
+	values.frames = frames.frames();
+	values.timeNs = timeNs;
+	values.stutters = frames.stutterCount();
+	values.swapchainRecreations = recreations;
+	values.acquireTimeouts = stats.acquire.timeouts;
+	values.events = m_events;
+	for (auto const& each : stats.memory.footprint) {
+		values.deviceBytes += each.device;
+		values.hostBytes += each.host;
+	}
+	for (auto const& heap : stats.memory.heaps) {
+		values.heapUsage += heap.usage;
+		values.heapBudget += heap.budget;
+	}
+	values.fps = frames.fps();
+	values.intervalP50Ms = frames.percentile(Metric::eInterval, 0.50f);
+	values.intervalP95Ms = frames.percentile(Metric::eInterval, 0.95f);
+	values.intervalP99Ms = frames.percentile(Metric::eInterval, 0.99f);
+	values.cpuP50Ms = frames.percentile(Metric::eCpu, 0.50f);
+	values.fenceWaitP50Ms = frames.percentile(Metric::eFenceWait, 0.50f);
+	values.fenceWaitP95Ms = frames.percentile(Metric::eFenceWait, 0.95f);
+	values.acquireP50Ms = frames.percentile(Metric::eAcquire, 0.50f);
+	values.acquireP95Ms = frames.percentile(Metric::eAcquire, 0.95f);
+	values.presentP50Ms = frames.percentile(Metric::ePresent, 0.50f);
+	values.presentP95Ms = frames.percentile(Metric::ePresent, 0.95f);
+	values.gpuMs = stats.gpu.empty() ? 0.0f : stats.gpu.latest().ms;
+	values.eventsLastPoll = static_cast<std::uint32_t>(events);
+	// seqlock write: readers retry while the sequence is odd or has moved
+	auto& sequence = m_segment->sequence;
+	auto const begin = sequence.load(std::memory_order_relaxed);
+	sequence.store(begin + 1U, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_segment->values = values;
+	sequence.store(begin + 2U, std::memory_order_release);
+}
+} // namespace dibs::detail
@@ -0,0 +1,34 @@
+#pragma once
+#include <dibs/stats.hpp>
+#include <dibs/stats_export.hpp>
+#include <memory>
+#include <string>
+
+namespace dibs::detail {
+// Builder::exportStats: publishes a stats_export::Segment in POSIX shared memory (not on Windows).
+// Only the segment's creation and removal make system calls
+class StatsExporter {
+  public:
+	struct Mapping {
+		void* segment{};
+		int fd{-1}; // locked while the segment is published
+	};
+
+	// null if disabled or unavailable
+	static std::unique_ptr<StatsExporter> make(std::string name);
+
+	StatsExporter() = default;
+	StatsExporter(StatsExporter&&) = delete;
+	StatsExporter& operator=(StatsExporter&&) = delete;
+	~StatsExporter();
+
+	// end of each Frame
+	void publish(Stats const& stats, std::uint64_t recreations, std::size_t events, std::uint64_t timeNs) noexcept;
+
+  private:
+	Mapping m_mapping{};
+	stats_export::Segment* m_segment{};
+	std::string m_name;
+	std::uint64_t m_events{};
+};
+} // namespace dibs::detail
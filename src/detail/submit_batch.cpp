@@ -0,0 +1,113 @@
+#include <detail/submit_batch.hpp>
+#include <dibs/profile.hpp>
+#include <utility>
+
+namespace dibs::detail {
+namespace {
+// legacy stage bits share values with their synchronization2 counterparts
+constexpr vk::PipelineStageFlags2 stages2(vk::PipelineStageFlags const stages) noexcept {
+	return vk::PipelineStageFlags2(static_cast<VkPipelineStageFlags2>(static_cast<VkPipelineStageFlags>(stages)));
+}
+
+template <typename T>
+T const* at(std::vector<T> const& vec, std::uint32_t const first) noexcept {
+	return vec.empty() ? nullptr : vec.data() + first;
+}
+} // namespace
+
+void SubmitBatch::add(VKSubmit const& submit) {
+	auto lock = std::scoped_lock(m_mutex);
+	push(submit, submit.afterFrame ? Order::eAfter : Order::eBefore);
+}
+
+bool SubmitBatch::empty() {
+	auto lock = std::scoped_lock(m_mutex);
+	return m_entries.empty();
+}
+
+vk::Result SubmitBatch::flush(VKDevice const& device, VKSubmit const& frame, vk::Fence const fence) {
+	DIBS_ZONE("dibs::submit");
+	auto lock = std::scoped_lock(m_mutex);
+	push(frame, Order::eFrame);
+	m_ordered.clear();
+	for (auto const order : {Order::eBefore, Order::eFrame, Order::eAfter}) {
+		for (auto const& entry : m_entries) {
+			if (entry.order == order) { m_ordered.push_back(&entry); }
+		}
+	}
+	auto const ret = device.features.test(VKFeature::eSynchronization2) ? submit2(device, fence) : submit(device, fence);
+	++m_submits;
+	m_batches += static_cast<std::uint32_t>(m_entries.size());
+	m_cbs.clear();
+	m_waits.clear();
+	m_signals.clear();
+	m_entries.clear();
+	return ret;
+}
+
+void SubmitBatch::sample(SubmitStats& out, bool const sync2) {
+	auto lock = std::scoped_lock(m_mutex);
+	m_total += m_submits;
+	out.submits = std::exchange(m_submits, 0U);
+	out.batches = std::exchange(m_batches, 0U);
+	out.total = m_total;
+	out.sync2 = sync2;
+}
+
+void SubmitBatch::push(VKSubmit const& submit, Order const order) {
+	auto const range = [](auto& vec, auto const span) {
+		auto const ret = Range{static_cast<std::uint32_t>(vec.size()), static_cast<std::uint32_t>(span.size())};
+		vec.insert(vec.end(), span.begin(), span.end());
+		return ret;
+	};
+	Entry entry;
+	entry.order = order;
+	entry.cbs = range(m_cbs, submit.commandBuffers);
+	entry.waits = range(m_waits, submit.waits);
+	entry.signals = range(m_signals, submit.signals);
+	m_entries.push_back(entry);
+}
+
+vk::Result SubmitBatch::submit2(VKDevice const& device, vk::Fence const fence) {
+	m_cbInfos.clear();
+	for (auto const cb : m_cbs) { m_cbInfos.push_back(vk::CommandBufferSubmitInfo(cb)); }
+	m_waitInfos.clear();
+	for (auto const& wait : m_waits) { m_waitInfos.push_back(vk::SemaphoreSubmitInfo(wait.semaphore, 0U, stages2(wait.stages))); }
+	m_signalInfos.clear();
+	for (auto const signal : m_signals) { m_signalInfos.push_back(vk::SemaphoreSubmitInfo(signal, 0U, vk::PipelineStageFlagBits2::eAllCommands)); }
+	m_infos2.clear();
+	for (auto const* entry : m_ordered) {
+		vk::SubmitInfo2 info;
+		info.waitSemaphoreInfoCount = entry->waits.count;
+		info.pWaitSemaphoreInfos = at(m_waitInfos, entry->waits.first);
+		info.commandBufferInfoCount = entry->cbs.count;
+		info.pCommandBufferInfos = at(m_cbInfos, entry->cbs.first);
+		info.signalSemaphoreInfoCount = entry->signals.count;
+		info.pSignalSemaphoreInfos = at(m_signalInfos, entry->signals.first);
+		m_infos2.push_back(info);
+	}
+	return device.queue.queue.submit2(static_cast<std::uint32_t>(m_infos2.size()), m_infos2.data(), fence);
+}
+
+vk::Result SubmitBatch::submit(VKDevice const& device, vk::Fence const fence) {
+	m_waitSemaphores.clear();
+	m_waitStages.clear();
+	for (auto const& wait : m_waits) {
+		m_waitSemaphores.push_back(wait.semaphore);
+		m_waitStages.push_back(wait.stages);
+	}
+	m_infos.clear();
+	for (auto const* entry : m_ordered) {
+		vk::SubmitInfo info;
+		info.waitSemaphoreCount = entry->waits.count;
+		info.pWaitSemaphores = at(m_waitSemaphores, entry->waits.first);
+		info.pWaitDstStageMask = at(m_waitStages, entry->waits.first);
+		info.commandBufferCount = entry->cbs.count;
+		info.pCommandBuffers = at(m_cbs, entry->cbs.first);
+		info.signalSemaphoreCount = entry->signals.count;
+		info.pSignalSemaphores = at(m_signals, entry->signals.first);
+		m_infos.push_back(info);
+	}
+	return device.queue.queue.submit(static_cast<std::uint32_t>(m_infos.size()), m_infos.data(), fence);
+}
+} // namespace dibs::detail
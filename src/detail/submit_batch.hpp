@@ -0,0 +1,58 @@
+#pragma once
+#include <dibs/bridge.hpp>
+#include <dibs/stats.hpp>
+#include <mutex>
+#include <vector>
+
+namespace dibs::detail {
+// batches for the graphics queue, flushed in one queue submission per frame
+class SubmitBatch {
+  public:
+	// thread safe
+	void add(VKSubmit const& submit);
+	bool empty();
+	// added batches and frame (between those before and after it) in one vkQueueSubmit2 / vkQueueSubmit, signalling fence
+	vk::Result flush(VKDevice const& device, VKSubmit const& frame, vk::Fence fence);
+	// a submission to another queue this frame (async compute)
+	void external() noexcept { ++m_submits; }
+	// counters for the frame, then resets them
+	void sample(SubmitStats& out, bool sync2);
+
+  private:
+	enum class Order : std::uint8_t { eBefore, eFrame, eAfter };
+
+	struct Range {
+		std::uint32_t first{};
+		std::uint32_t count{};
+	};
+
+	struct Entry {
+		Range cbs;
+		Range waits;
+		Range signals;
+		Order order{};
+	};
+
+	void push(VKSubmit const& submit, Order order);
+	vk::Result submit2(VKDevice const& device, vk::Fence fence);
+	vk::Result submit(VKDevice const& device, vk::Fence fence);
+
+	std::mutex m_mutex;
+	std::vector<vk::CommandBuffer> m_cbs;
+	std::vector<VKWait> m_waits;
+	std::vector<vk::Semaphore> m_signals;
+	std::vector<Entry> m_entries;
+	// scratch, reused across frames: 1:1 with the arrays above, in submission order
+	std::vector<Entry const*> m_ordered;
+	std::vector<vk::SubmitInfo2> m_infos2;
+	std::vector<vk::CommandBufferSubmitInfo> m_cbInfos;
+	std::vector<vk::SemaphoreSubmitInfo> m_waitInfos;
+	std::vector<vk::SemaphoreSubmitInfo> m_signalInfos;
+	std::vector<vk::SubmitInfo> m_infos;
+	std::vector<vk::Semaphore> m_waitSemaphores;
+	std::vector<vk::PipelineStageFlags> m_waitStages;
+	std::uint32_t m_submits{};
+	std::uint32_t m_batches{};
+	std::uint64_t m_total{};
+};
+} // namespace dibs::detail
@@ -0,0 +1,73 @@
+#include <detail/expect.hpp>
+#include <detail/job_system.hpp>
+#include <detail/task_scheduler.hpp>
+#include <algorithm>
+
+namespace dibs::detail {
+void TaskScheduler::spawn(Task::Handle const task) {
+	m_tasks.push_back(task);
+	task.resume();
+	sweep();
+}
+
+void TaskScheduler::frame(Frame const& frame) {
+	m_frame = &frame;
+	// coroutines awaiting the next frame again are queued for the one after.
+	// Local: a resumed coroutine may re-enter the scheduler
+	auto resume = std::vector<std::coroutine_handle<>>{};
+	std::swap(resume, m_frameWaits);
+	for (auto const handle : resume) { handle.resume(); }
+	m_frame = {};
+	sweep();
+}
+
+void TaskScheduler::poll(std::uint64_t const completed) {
+	m_completed = std::max(m_completed, completed);
+	auto finished = std::vector<std::coroutine_handle<>>{};
+	{
+		auto lock = std::scoped_lock(m_mutex);
+		std::swap(finished, m_finished);
+	}
+	for (auto const handle : finished) { handle.resume(); }
+	auto const ready = std::stable_partition(m_gpuWaits.begin(), m_gpuWaits.end(), [this](GpuWait const& wait) { return !executed(wait.frame); });
+	auto gpuDone = std::vector<std::coroutine_handle<>>{};
+	for (auto it = ready; it != m_gpuWaits.end(); ++it) { gpuDone.push_back(it->handle); }
+	m_gpuWaits.erase(ready, m_gpuWaits.end());
+	for (auto const handle : gpuDone) { handle.resume(); }
+	sweep();
+}
+
+void TaskScheduler::clear() {
+	// work may reference the frames of waiting coroutines
+	while (m_running.load() > 0U) { m_jobs->wait(JobPhase::eAsync); }
+	m_finished.clear();
+	m_frameWaits.clear();
+	m_gpuWaits.clear();
+	// destroys nested tasks too (owned by their awaiters' frames)
+	for (auto const task : m_tasks) { task.destroy(); }
+	m_tasks.clear();
+}
+
+void TaskScheduler::run(std::coroutine_handle<> const handle, Background::Work&& work) {
+	EXPECT(m_jobs);
+	m_running.fetch_add(1U);
+	auto job = [this, handle, work = std::move(work)]() mutable {
+		work();
+		{
+			auto lock = std::scoped_lock(m_mutex);
+			m_finished.push_back(handle);
+		}
+		m_running.fetch_sub(1U);
+	};
+	m_jobs->push(std::move(job), JobPhase::eAsync);
+}
+
+void TaskScheduler::sweep() {
+	auto const done = [](Task::Handle const task) {
+		if (!task.done()) { return false; }
+		task.destroy();
+		return true;
+	};
+	std::erase_if(m_tasks, done);
+}
+} // namespace dibs::detail
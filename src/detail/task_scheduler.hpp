@@ -0,0 +1,56 @@
+#pragma once
+#include <dibs/task.hpp>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace dibs::detail {
+class JobSystem;
+
+// owns spawned tasks and resumes suspended coroutines at fixed points: Frame construction (NextFrame), poll() (GpuComplete, Background)
+class TaskScheduler {
+  public:
+	TaskScheduler() = default;
+	TaskScheduler(TaskScheduler&&) = delete;
+	TaskScheduler& operator=(TaskScheduler&&) = delete;
+	~TaskScheduler() { clear(); }
+
+	// runs Background work; must outlive this
+	void jobs(JobSystem& jobs) noexcept { m_jobs = &jobs; }
+
+	// takes ownership, runs until the first suspension
+	void spawn(Task::Handle task);
+	// resume frame waiters; frame must outlive the call
+	void frame(Frame const& frame);
+	// resume finished background work and GPU waiters; frames before completed have executed
+	void poll(std::uint64_t completed);
+	// wait for background work and destroy all tasks
+	void clear();
+
+	void waitFrame(std::coroutine_handle<> handle) { m_frameWaits.push_back(handle); }
+	void waitGpu(std::coroutine_handle<> handle, std::uint64_t frame) { m_gpuWaits.push_back({handle, frame}); }
+	void run(std::coroutine_handle<> handle, Background::Work&& work);
+
+	bool executed(std::uint64_t frame) const noexcept { return frame < m_completed; }
+	Frame const& current() const noexcept { return *m_frame; }
+
+  private:
+	struct GpuWait {
+		std::coroutine_handle<> handle;
+		std::uint64_t frame{};
+	};
+
+	void sweep();
+
+	std::vector<Task::Handle> m_tasks;
+	std::vector<std::coroutine_handle<>> m_frameWaits;
+	std::vector<GpuWait> m_gpuWaits;
+	std::uint64_t m_completed{};
+	Frame const* m_frame{};
+
+	JobSystem* m_jobs{};
+	std::mutex m_mutex; // finished
+	std::vector<std::coroutine_handle<>> m_finished;
+	std::atomic<std::size_t> m_running{}; // background work
+};
+} // namespace dibs::detail
@@ -1,14 +1,217 @@
 #include <VkBootstrap.h>
+#include <detail/log.hpp>
 #include <detail/vk_instance.hpp>
+#include <algorithm>
+#include <cctype>
+#include <span>
+#include <string_view>
 
 namespace dibs::detail {
-Result<VKInstance> VKInstance::make(MakeSurface const makeSurface, Flags const flags) {
+namespace {
+constexpr std::uint32_t api_version_v = VK_API_VERSION_1_3;
+
+// always desired: dibs uses these where available
+constexpr GpuFeatures dibs_features_v = GpuFeatures(GpuFeature::eDynamicRendering) | GpuFeature::eSynchronization2 | GpuFeature::ePipelineStatistics |
+									   GpuFeature::eAsyncCompute;
+
+constexpr GpuFeature all_features_v[] = {
+	GpuFeature::eDynamicRendering,	 GpuFeature::eSynchronization2,	  GpuFeature::ePipelineStatistics, GpuFeature::eAsyncCompute,
+	GpuFeature::eDescriptorIndexing, GpuFeature::eTimelineSemaphore, GpuFeature::eBufferDeviceAddress, GpuFeature::eSamplerAnisotropy,
+	GpuFeature::eFillModeNonSolid,	 GpuFeature::eWideLines,
+};
+
+struct FeatureExtension {
+	GpuFeature feature;
+	std::uint32_t promoted;
+	char const* extensions[3];
+};
+
+// extensions (and dependencies) providing a feature before it was promoted to core
+constexpr FeatureExtension feature_extensions_v[] = {
+	{GpuFeature::eDynamicRendering,
+	 VK_API_VERSION_1_3,
+	 {VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME, VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME, VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME}},
+	{GpuFeature::eSynchronization2, VK_API_VERSION_1_3, {VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME}},
+	{GpuFeature::eDescriptorIndexing, VK_API_VERSION_1_2, {VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME}},
+	{GpuFeature::eTimelineSemaphore, VK_API_VERSION_1_2, {VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME}},
+	{GpuFeature::eBufferDeviceAddress, VK_API_VERSION_1_2, {VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME}},
+};
+
+bool hasExtension(std::span<vk::ExtensionProperties const> available, std::string_view const name) noexcept {
+	auto const match = [name](vk::ExtensionProperties const& ext) { return std::string_view(ext.extensionName) == name; };
+	return std::any_of(available.begin(), available.end(), match);
+}
+
+bool supported(std::uint32_t const api, std::span<vk::ExtensionProperties const> available, GpuFeature const feature) noexcept {
+	for (auto const& fe : feature_extensions_v) {
+		if (fe.feature == feature) { return api >= fe.promoted || hasExtension(available, fe.extensions[0]); }
+	}
+	return true;
+}
+
+template <typename T>
+T features(vk::PhysicalDevice const gpu) {
+	return gpu.getFeatures2<vk::PhysicalDeviceFeatures2, T>().template get<T>();
+}
+
+std::uint32_t apiVersion(vk::PhysicalDevice const gpu) { return std::min({api_version_v, vk::enumerateInstanceVersion(), gpu.getProperties().apiVersion}); }
+
+bool separateCompute(vk::PhysicalDevice const gpu) {
+	for (auto const& family : gpu.getQueueFamilyProperties()) {
+		if ((family.queueFlags & vk::QueueFlagBits::eCompute) && !(family.queueFlags & vk::QueueFlagBits::eGraphics)) { return true; }
+	}
+	return false;
+}
+
+GpuFeatures supportedFeatures(vk::PhysicalDevice const gpu) {
+	GpuFeatures ret;
+	auto const api = apiVersion(gpu);
+	auto const available = gpu.enumerateDeviceExtensionProperties();
+	auto const has = [&](GpuFeature feature) { return supported(api, available, feature); };
+	auto const core = gpu.getFeatures();
+	if (has(GpuFeature::eDynamicRendering) && features<vk::PhysicalDeviceDynamicRenderingFeatures>(gpu).dynamicRendering) {
+		ret.set(GpuFeature::eDynamicRendering);
+	}
+	if (has(GpuFeature::eSynchronization2) && features<vk::PhysicalDeviceSynchronization2Features>(gpu).synchronization2) {
+		ret.set(GpuFeature::eSynchronization2);
+	}
+	if (has(GpuFeature::eDescriptorIndexing) && features<vk::PhysicalDeviceDescriptorIndexingFeatures>(gpu).runtimeDescriptorArray) {
+		ret.set(GpuFeature::eDescriptorIndexing);
+	}
+	if (has(GpuFeature::eTimelineSemaphore) && features<vk::PhysicalDeviceTimelineSemaphoreFeatures>(gpu).timelineSemaphore) {
+		ret.set(GpuFeature::eTimelineSemaphore);
+	}
+	if (has(GpuFeature::eBufferDeviceAddress) && features<vk::PhysicalDeviceBufferDeviceAddressFeatures>(gpu).bufferDeviceAddress) {
+		ret.set(GpuFeature::eBufferDeviceAddress);
+	}
+	// the frame's statistics query stays active while job-recorded secondary command buffers execute
+	if (core.pipelineStatisticsQuery && core.inheritedQueries) { ret.set(GpuFeature::ePipelineStatistics); }
+	if (core.samplerAnisotropy) { ret.set(GpuFeature::eSamplerAnisotropy); }
+	if (core.fillModeNonSolid) { ret.set(GpuFeature::eFillModeNonSolid); }
+	if (core.wideLines) { ret.set(GpuFeature::eWideLines); }
+	if (separateCompute(gpu)) { ret.set(GpuFeature::eAsyncCompute); }
+	return ret;
+}
+
+std::string uuid(vk::PhysicalDevice const gpu) {
+	static constexpr char hex_v[] = "0123456789abcdef";
+	auto const id = gpu.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>().get<vk::PhysicalDeviceIDProperties>();
+	std::string ret;
+	for (std::uint8_t const byte : id.deviceUUID) {
+		ret += hex_v[byte >> 4U];
+		ret += hex_v[byte & 0xfU];
+	}
+	return ret;
+}
+
+std::string lower(std::string_view const str) {
+	std::string ret;
+	for (char const c : str) {
+		if (c != '-') { ret += char(std::tolower(static_cast<unsigned char>(c))); }
+	}
+	return ret;
+}
+
+bool matches(std::string_view const name, std::string_view const id, std::string_view const select) {
+	auto const key = lower(select);
+	return key == id || lower(name).find(key) != std::string::npos;
+}
+
+// higher is better; unmet required features / extensions are filtered out before scoring
+std::int64_t score(vk::PhysicalDevice const gpu, GpuFeatures const supported, GpuRequest const& request) {
+	auto const props = gpu.getProperties();
+	std::int64_t ret{};
+	switch (props.deviceType) {
+	case vk::PhysicalDeviceType::eDiscreteGpu: ret += 1000; break;
+	case vk::PhysicalDeviceType::eIntegratedGpu: ret += 500; break;
+	case vk::PhysicalDeviceType::eVirtualGpu: ret += 200; break;
+	default: break;
+	}
+	// largest device local heap, in 256 MiB units (capped)
+	vk::DeviceSize local{};
+	auto const memory = gpu.getMemoryProperties();
+	for (std::uint32_t i = 0; i < memory.memoryHeapCount; ++i) {
+		if (memory.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal) { local = std::max(local, memory.memoryHeaps[i].size); }
+	}
+	ret += std::min(std::int64_t(local >> 28U), std::int64_t(256)) * 2;
+	// queue families: async compute and dedicated transfer
+	for (auto const& family : gpu.getQueueFamilyProperties()) {
+		if ((family.queueFlags & vk::QueueFlagBits::eTransfer) && !(family.queueFlags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))) {
+			ret += 50;
+			break;
+		}
+	}
+	// limits
+	ret += std::int64_t(props.limits.maxImageDimension2D / 1024U) * 10;
+	ret += std::int64_t(props.limits.maxComputeSharedMemorySize / 1024U);
+	ret += std::int64_t(props.limits.maxBoundDescriptorSets) * 5;
+	if (apiVersion(gpu) >= VK_API_VERSION_1_3) { ret += 50; }
+	// desired features and extensions
+	auto const desired = request.desired | dibs_features_v;
+	for (auto const feature : all_features_v) {
+		if (desired.test(feature) && supported.test(feature)) { ret += 100; }
+	}
+	auto const available = gpu.enumerateDeviceExtensionProperties();
+	for (auto const& ext : request.desiredExtensions) {
+		if (hasExtension(available, ext)) { ret += 50; }
+	}
+	return ret;
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL onDebugMessage(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT,
+											  VkDebugUtilsMessengerCallbackDataEXT const* data, void*) {
+	std::string_view const msg = data && data->pMessage ? data->pMessage : "";
+	if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+		error("[Vulkan] {}", msg);
+	} else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+		warn("[Vulkan] {}", msg);
+	} else {
+		trace("[Vulkan] {}", msg);
+	}
+	return VK_FALSE;
+}
+
+struct Candidate {
+	vkb::PhysicalDevice device;
+	GpuFeatures supported;
+	std::int64_t score{};
+};
+
+std::optional<Candidate> select(std::vector<vkb::PhysicalDevice> devices, GpuRequest const& request) {
+	std::vector<Candidate> candidates;
+	for (auto& device : devices) {
+		auto const gpu = vk::PhysicalDevice(device.physical_device);
+		auto const supported = supportedFeatures(gpu);
+		std::string_view const name = device.properties.deviceName;
+		if ((supported & request.required) != request.required) {
+			log("GPU [{}] is missing required features", name);
+			continue;
+		}
+		auto const points = score(gpu, supported, request);
+		log("GPU [{}] ({}) score: {}", name, uuid(gpu), points);
+		candidates.push_back({std::move(device), supported, points});
+	}
+	if (candidates.empty()) { return std::nullopt; }
+	if (!request.select.empty()) {
+		for (auto& candidate : candidates) {
+			auto const gpu = vk::PhysicalDevice(candidate.device.physical_device);
+			if (matches(candidate.device.properties.deviceName, uuid(gpu), request.select)) { return std::move(candidate); }
+		}
+		warn("No suitable GPU matches [{}], selecting by score", request.select);
+	}
+	auto const byScore = [](Candidate const& a, Candidate const& b) { return a.score < b.score; };
+	return std::move(*std::max_element(candidates.begin(), candidates.end(), byScore));
+}
+} // namespace
+
+Result<VKInstance> VKInstance::make(MakeSurface const makeSurface, Flags const flags, GpuRequest const& request) {
 	if (!makeSurface) { return Error::eInvalidArg; }
 	vk::DynamicLoader dl;
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(dl.getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr"));
 	vkb::InstanceBuilder vib;
 	if (flags.test(Flag::eValidation)) { vib.request_validation_layers(); }
-	auto vi = vib.set_app_name("dibs").use_default_debug_messenger().build();
+	vib.require_api_version(1, 1, 0).desire_api_version(1, 3, 0);
+	auto vi = vib.set_app_name("dibs").set_debug_callback(&onDebugMessage).build();
 	if (!vi) { return Error::eVulkanInitFailure; }
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(vi->instance);
 	VKInstance ret;
@@ -18,12 +221,73 @@ Result<VKInstance> VKInstance::make(MakeSurface const makeSurface, Flags const f
 	if (!surface) { return Error::eVulkanInitFailure; }
 	ret.surface = vk::UniqueSurfaceKHR(surface, {vi->instance});
 	vkb::PhysicalDeviceSelector vpds(vi.value());
-	auto vpd = vpds.require_present().prefer_gpu_device_type(vkb::PreferredDeviceType::discrete).set_surface(surface).select();
-	if (!vpd) { return Error::eVulkanInitFailure; }
-	ret.gpu.properties = vk::PhysicalDeviceProperties(vpd->properties);
-	ret.gpu.device = vk::PhysicalDevice(vpd->physical_device);
+	auto const wanted = request.required | request.desired | dibs_features_v;
+	// extensions backing wanted features are only needed pre-promotion: desired, and checked per device
+	std::vector<std::string> desired = request.desiredExtensions;
+	for (auto const& fe : feature_extensions_v) {
+		if (!wanted.test(fe.feature)) { continue; }
+		for (auto const* ext : fe.extensions) {
+			if (ext) { desired.push_back(ext); }
+		}
+	}
+	// per heap budgets for Stats::memory / Bridge::memoryBudget
+	desired.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	for (auto const& ext : request.requiredExtensions) { vpds.add_required_extension(ext.c_str()); }
+	for (auto const& ext : desired) { vpds.add_desired_extension(ext.c_str()); }
+	auto devices = vpds.require_present().set_surface(surface).select_devices();
+	if (!devices || devices->empty()) { return Error::eNoSuitableGpu; }
+	auto candidate = select(std::move(devices).value(), request);
+	if (!candidate) { return Error::eNoSuitableGpu; }
+	auto& vpd = candidate->device;
+	ret.gpu.properties = vk::PhysicalDeviceProperties(vpd.properties);
+	ret.gpu.memory = vk::PhysicalDeviceMemoryProperties(vpd.memory_properties);
+	ret.gpu.device = vk::PhysicalDevice(vpd.physical_device);
 	ret.gpu.formats = ret.gpu.device.getSurfaceFormatsKHR(*ret.surface);
-	vkb::DeviceBuilder vdb(vpd.value());
+	auto const enable = candidate->supported & wanted;
+	// vk-bootstrap enables the required and available desired extensions
+	auto const available = ret.gpu.device.enumerateDeviceExtensionProperties();
+	ret.extensions = request.requiredExtensions;
+	for (auto const& ext : desired) {
+		if (hasExtension(available, ext) && std::find(ret.extensions.begin(), ret.extensions.end(), ext) == ret.extensions.end()) {
+			ret.extensions.push_back(ext);
+		}
+	}
+	vkb::DeviceBuilder vdb(vpd);
+	vk::PhysicalDeviceDynamicRenderingFeatures dynamicRendering;
+	if (enable.test(GpuFeature::eDynamicRendering)) {
+		dynamicRendering.dynamicRendering = true;
+		vdb.add_pNext(&dynamicRendering);
+	}
+	vk::PhysicalDeviceSynchronization2Features synchronization2;
+	if (enable.test(GpuFeature::eSynchronization2)) {
+		synchronization2.synchronization2 = true;
+		vdb.add_pNext(&synchronization2);
+	}
+	// enable every supported descriptor indexing capability
+	vk::PhysicalDeviceDescriptorIndexingFeatures descriptorIndexing;
+	if (enable.test(GpuFeature::eDescriptorIndexing)) {
+		descriptorIndexing = features<vk::PhysicalDeviceDescriptorIndexingFeatures>(ret.gpu.device);
+		descriptorIndexing.pNext = nullptr;
+		vdb.add_pNext(&descriptorIndexing);
+	}
+	vk::PhysicalDeviceTimelineSemaphoreFeatures timelineSemaphore;
+	if (enable.test(GpuFeature::eTimelineSemaphore)) {
+		timelineSemaphore.timelineSemaphore = true;
+		vdb.add_pNext(&timelineSemaphore);
+	}
+	vk::PhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddress;
+	if (enable.test(GpuFeature::eBufferDeviceAddress)) {
+		bufferDeviceAddress.bufferDeviceAddress = true;
+		vdb.add_pNext(&bufferDeviceAddress);
+	}
+	// vk-bootstrap enables features through a chained PhysicalDeviceFeatures2 instead of pEnabledFeatures if one is present
+	vk::PhysicalDeviceFeatures2 features2;
+	features2.features = vk::PhysicalDeviceFeatures(vpd.features);
+	features2.features.pipelineStatisticsQuery = features2.features.inheritedQueries = enable.test(GpuFeature::ePipelineStatistics);
+	features2.features.samplerAnisotropy = enable.test(GpuFeature::eSamplerAnisotropy);
+	features2.features.fillModeNonSolid = enable.test(GpuFeature::eFillModeNonSolid);
+	features2.features.wideLines = enable.test(GpuFeature::eWideLines);
+	vdb.add_pNext(&features2);
 	auto vd = vdb.build();
 	if (!vd) { return Error::eVulkanInitFailure; }
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(vd->device);
@@ -32,6 +296,22 @@ Result<VKInstance> VKInstance::make(MakeSurface const makeSurface, Flags const f
 	auto qfam = vd->get_queue_index(vkb::QueueType::graphics);
 	if (!queue || !qfam) { return Error::eVulkanInitFailure; }
 	ret.queue = VKQueue{vk::Queue(queue.value()), qfam.value()};
+	ret.features = enable;
+	ret.features.reset(GpuFeature::eAsyncCompute);
+	// async compute: prefer a compute-only family, then any family other than graphics
+	auto compute = vd->get_dedicated_queue(vkb::QueueType::compute);
+	auto cfam = vd->get_dedicated_queue_index(vkb::QueueType::compute);
+	if (!compute || !cfam) {
+		compute = vd->get_separate_queue(vkb::QueueType::compute);
+		cfam = vd->get_separate_queue_index(vkb::QueueType::compute);
+	}
+	if (compute && cfam) {
+		ret.compute = VKQueue{vk::Queue(compute.value()), cfam.value()};
+		ret.features.set(GpuFeature::eAsyncCompute);
+	} else {
+		ret.compute = ret.queue;
+	}
+	if ((ret.features & request.required) != request.required) { return Error::eNoSuitableGpu; }
 	return ret;
 }
 } // namespace dibs::detail
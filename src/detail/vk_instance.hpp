@@ -3,10 +3,20 @@
 #include <dibs/error.hpp>
 #include <ktl/async/kfunction.hpp>
 #include <ktl/enum_flags/enum_flags.hpp>
+#include <string>
+#include <vector>
 
 namespace dibs::detail {
 using MakeSurface = ktl::kfunction<vk::SurfaceKHR(vk::Instance)>;
 
+struct GpuRequest {
+	GpuFeatures required;
+	GpuFeatures desired;
+	std::vector<std::string> requiredExtensions;
+	std::vector<std::string> desiredExtensions;
+	std::string select; // device name (case-insensitive substring) or UUID; overrides scoring
+};
+
 struct VKInstance {
 	enum class Flag { eValidation };
 	using Flags = ktl::enum_flags<Flag, std::uint8_t>;
@@ -17,7 +27,10 @@ struct VKInstance {
 	vk::UniqueDevice device;
 	vk::UniqueSurfaceKHR surface;
 	VKQueue queue;
+	VKQueue compute;
+	VKFeatures features;
+	std::vector<std::string> extensions;
 
-	static Result<VKInstance> make(MakeSurface makeSurface, Flags flags);
+	static Result<VKInstance> make(MakeSurface makeSurface, Flags flags, GpuRequest const& request);
 };
 } // namespace dibs::detail
@@ -0,0 +1,17 @@
+#include <detail/vk_memory.hpp>
+
+namespace dibs::detail {
+std::optional<std::uint32_t> memoryType(vk::PhysicalDeviceMemoryProperties const& props, std::uint32_t const typeBits, vk::MemoryPropertyFlags const flags) noexcept {
+	for (std::uint32_t i = 0; i < props.memoryTypeCount; ++i) {
+		if ((typeBits & (1U << i)) && (props.memoryTypes[i].propertyFlags & flags) == flags) { return i; }
+	}
+	return std::nullopt;
+}
+
+vk::UniqueDeviceMemory allocate(vk::Device const device, vk::PhysicalDeviceMemoryProperties const& props, vk::MemoryRequirements const& mr,
+								vk::MemoryPropertyFlags const flags, void const* const next) {
+	auto const type = memoryType(props, mr.memoryTypeBits, flags);
+	if (!type) { return {}; }
+	return device.allocateMemoryUnique(vk::MemoryAllocateInfo(mr.size, *type, next));
+}
+} // namespace dibs::detail
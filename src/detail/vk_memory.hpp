@@ -0,0 +1,9 @@
+#pragma once
+#include <vulkan/vulkan.hpp>
+#include <optional>
+
+namespace dibs::detail {
+std::optional<std::uint32_t> memoryType(vk::PhysicalDeviceMemoryProperties const& props, std::uint32_t typeBits, vk::MemoryPropertyFlags flags) noexcept;
+vk::UniqueDeviceMemory allocate(vk::Device device, vk::PhysicalDeviceMemoryProperties const& props, vk::MemoryRequirements const& mr, vk::MemoryPropertyFlags flags,
+								 void const* next = nullptr);
+} // namespace dibs::detail
@@ -3,24 +3,13 @@
 #include <detail/log.hpp>
 #include <detail/vk_instance.hpp>
 #include <detail/vk_surface.hpp>
+#include <dibs/profile.hpp>
 #include <algorithm>
 #include <limits>
 #include <span>
 
 namespace dibs::detail {
 namespace {
-constexpr vk::Format imageFormat(std::span<vk::SurfaceFormatKHR const> formats) noexcept {
-	constexpr vk::Format targets[] = {vk::Format::eR8G8B8A8Unorm, vk::Format::eB8G8R8A8Unorm};
-	for (auto const format : formats) {
-		if (format.colorSpace == vk::ColorSpaceKHR::eVkColorspaceSrgbNonlinear) {
-			for (auto const target : targets) {
-				if (format == target) { return format.format; }
-			}
-		}
-	}
-	return formats.empty() ? vk::Format() : formats.front().format;
-}
-
 constexpr std::uint32_t imageCount(vk::SurfaceCapabilitiesKHR const& caps) noexcept {
 	if (caps.maxImageCount < caps.minImageCount) { return std::max(3U, caps.minImageCount); }
 	return std::clamp(3U, caps.minImageCount, caps.maxImageCount);
@@ -58,7 +47,29 @@ vk::UniqueImageView makeImageView(vk::Device const device, vk::Image const image
 }
 } // namespace
 
-vk::SwapchainCreateInfoKHR VKSurface::makeInfo(VKDevice const& device, vk::SurfaceKHR const surface, uvec2 const framebuffer) noexcept {
+vk::Format imageFormat(std::span<vk::SurfaceFormatKHR const> const formats) noexcept {
+	constexpr vk::Format targets[] = {vk::Format::eR8G8B8A8Unorm, vk::Format::eB8G8R8A8Unorm};
+	for (auto const format : formats) {
+		if (format.colorSpace == vk::ColorSpaceKHR::eVkColorspaceSrgbNonlinear) {
+			for (auto const target : targets) {
+				if (format == target) { return format.format; }
+			}
+		}
+	}
+	return formats.empty() ? vk::Format() : formats.front().format;
+}
+
+vk::DeviceSize texelBytes(vk::Format const format) noexcept {
+	switch (format) {
+	case vk::Format::eR16G16B16A16Sfloat:
+	case vk::Format::eR16G16B16A16Unorm: return 8U;
+	case vk::Format::eR32G32B32A32Sfloat: return 16U;
+	default: return 4U;
+	}
+}
+
+vk::SwapchainCreateInfoKHR VKSurface::makeInfo(VKDevice const& device, vk::SurfaceKHR const surface, uvec2 const framebuffer,
+											   vk::ImageUsageFlags const usage) noexcept {
 	vk::SwapchainCreateInfoKHR ret;
 	ret.surface = surface;
 	ret.presentMode = vk::PresentModeKHR::eFifo;
@@ -69,22 +80,32 @@ vk::SwapchainCreateInfoKHR VKSurface::makeInfo(VKDevice const& device, vk::Surfa
 	ret.imageArrayLayers = 1U;
 	ret.imageFormat = imageFormat(device.gpu.formats);
 	auto const caps = device.gpu.device.getSurfaceCapabilitiesKHR(surface);
+	// dynamic resolution upscales into the image with a blit
+	ret.imageUsage |= caps.supportedUsageFlags & (vk::ImageUsageFlagBits::eTransferDst | usage);
 	ret.imageExtent = imageExtent(caps, framebuffer);
 	ret.minImageCount = imageCount(caps);
 	return ret;
 }
 
+vk::DeviceSize VKSurface::bytes() const noexcept {
+	auto const& extent = swapchain.images.empty() ? vk::Extent2D{} : swapchain.images.front().extent;
+	return vk::DeviceSize(swapchain.images.size()) * extent.width * extent.height * texelBytes(info.imageFormat);
+}
+
 vk::Result VKSurface::refresh(VKDevice const& device, uvec2 const framebuffer) {
+	DIBS_ZONE("dibs::swapchain_refresh");
 	if (framebuffer.x == 0 || framebuffer.y == 0) { return vk::Result::eNotReady; }
-	info = makeInfo(device, surface, framebuffer);
+	auto const held = bytes();
+	info = makeInfo(device, surface, framebuffer, usage);
 	info.oldSwapchain = *swapchain.swapchain;
 	vk::SwapchainKHR vks;
 	auto const ret = device.device.createSwapchainKHR(&info, nullptr, &vks);
 	EXPECT(ret == vk::Result::eSuccess);
 	if (ret == vk::Result::eSuccess) {
 		trace("Swapchain resized: {}x{}", info.imageExtent.width, info.imageExtent.height);
+		if (info.oldSwapchain) { ++recreations; }
 		if (deferQueue) {
-			deferQueue->defer(std::move(swapchain)); // defer destruction of current swapchain and its image views if possible
+			deferQueue->defer(std::move(swapchain), held); // defer destruction of current swapchain and its image views if possible
 		} else {
 			device.device.waitIdle(); // otherwise stall device
 		}
@@ -99,10 +120,20 @@ vk::Result VKSurface::refresh(VKDevice const& device, uvec2 const framebuffer) {
 	return ret;
 }
 
-std::optional<VKSurface::Acquire> VKSurface::acquire(VKDevice const& device, vk::Semaphore const signal, uvec2 const framebuffer) {
-	static constexpr auto max_wait_v = std::numeric_limits<std::uint64_t>::max();
+std::optional<VKSurface::Acquire> VKSurface::acquire(VKDevice const& device, vk::Semaphore const signal, uvec2 const framebuffer, std::uint64_t const timeoutNs,
+													 bool& timedOut) {
+	DIBS_ZONE("dibs::acquire");
+	timedOut = false;
+	// none after a failed refresh: retry
+	if (!swapchain.swapchain) {
+		refresh(device, framebuffer);
+		return std::nullopt;
+	}
 	std::uint32_t idx{};
-	auto result = presentResult(device.device.acquireNextImageKHR(*swapchain.swapchain, max_wait_v, signal, {}, &idx));
+	auto const raw = device.device.acquireNextImageKHR(*swapchain.swapchain, timeoutNs, signal, {}, &idx);
+	// no image yet: signal is left unsignalled
+	timedOut = raw == vk::Result::eTimeout || raw == vk::Result::eNotReady;
+	auto result = presentResult(raw);
 	if (!result) { return std::nullopt; }
 	if (*result == PresentOutcome::eNotReady) {
 		refresh(device, framebuffer);
@@ -113,21 +144,8 @@ std::optional<VKSurface::Acquire> VKSurface::acquire(VKDevice const& device, vk:
 	return Acquire{swapchain.images[i], idx};
 }
 
-vk::Result VKSurface::submit(VKDevice const& device, vk::CommandBuffer const cb, Sync const& sync) {
-	static constexpr vk::PipelineStageFlags waitStages = vk::PipelineStageFlagBits::eTopOfPipe;
-	vk::SubmitInfo submitInfo;
-	submitInfo.pWaitDstStageMask = &waitStages;
-	submitInfo.commandBufferCount = 1U;
-	submitInfo.pCommandBuffers = &cb;
-	submitInfo.waitSemaphoreCount = 1U;
-	submitInfo.pWaitSemaphores = &sync.wait;
-	submitInfo.signalSemaphoreCount = 1U;
-	submitInfo.pSignalSemaphores = &sync.ssignal;
-	auto const ret = device.queue.queue.submit(1U, &submitInfo, sync.fsignal);
-	return ret;
-}
-
 PresentResult VKSurface::present(VKDevice const& device, Acquire const& acquired, vk::Semaphore const wait, uvec2 const framebuffer) {
+	DIBS_ZONE("dibs::present");
 	vk::PresentInfoKHR info;
 	info.waitSemaphoreCount = 1;
 	info.pWaitSemaphores = &wait;
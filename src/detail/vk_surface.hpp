@@ -4,6 +4,7 @@
 #include <ktl/fixed_vector.hpp>
 #include <vulkan/vulkan.hpp>
 #include <optional>
+#include <span>
 
 namespace dibs {
 struct VKDevice;
@@ -25,13 +26,12 @@ struct VKSwapchain {
 enum class PresentOutcome { eSuccess, eNotReady };
 using PresentResult = ktl::expected<PresentOutcome, vk::Result>;
 
-struct VKSurface {
-	struct Sync {
-		vk::Semaphore wait;
-		vk::Semaphore ssignal;
-		vk::Fence fsignal;
-	};
+// the format refresh() picks from the surface's formats
+vk::Format imageFormat(std::span<vk::SurfaceFormatKHR const> formats) noexcept;
+// swapchain formats: 8 / 10 bit packed unless wide
+vk::DeviceSize texelBytes(vk::Format format) noexcept;
 
+struct VKSurface {
 	struct Acquire {
 		VKImage image;
 		std::uint32_t index{};
@@ -43,12 +43,17 @@ struct VKSurface {
 	VKSwapchain swapchain;
 	vk::SurfaceKHR surface;
 	class DeferQueue* deferQueue{};
+	vk::ImageUsageFlags usage; // requested in addition, if supported
+	std::uint64_t recreations{}; // swapchains replaced by refresh
+
+	static vk::SwapchainCreateInfoKHR makeInfo(VKDevice const& device, vk::SurfaceKHR surface, uvec2 framebuffer, vk::ImageUsageFlags usage = {}) noexcept;
 
-	static vk::SwapchainCreateInfoKHR makeInfo(VKDevice const& device, vk::SurfaceKHR surface, uvec2 framebuffer) noexcept;
+	// estimated from extent and format: swapchain images are allocated by the driver
+	vk::DeviceSize bytes() const noexcept;
 
 	vk::Result refresh(VKDevice const& device, uvec2 framebuffer);
-	std::optional<Acquire> acquire(VKDevice const& device, vk::Semaphore signal, uvec2 framebuffer);
-	vk::Result submit(VKDevice const& device, vk::CommandBuffer cb, Sync const& sync);
+	// nullopt on timeout (timeoutNs: zero polls) as well as when the swapchain must be / was refreshed
+	std::optional<Acquire> acquire(VKDevice const& device, vk::Semaphore signal, uvec2 framebuffer, std::uint64_t timeoutNs, bool& timedOut);
 	PresentResult present(VKDevice const& device, Acquire const& acquired, vk::Semaphore wait, uvec2 framebuffer);
 };
 } // namespace dibs::detail
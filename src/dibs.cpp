@@ -2,10 +2,21 @@
 #include <detail/log.hpp>
 #include <dibs/dibs.hpp>
 #include <dibs/dibs_version.hpp>
+#include <dibs/frame_graph.hpp>
+#include <dibs/jobs.hpp>
+#include <dibs/pixels.hpp>
+#include <dibs/profile.hpp>
+#include <dibs/task.hpp>
 #include <instance_impl.hpp>
+#include <algorithm>
+#include <cstdlib>
 
 namespace dibs {
 namespace {
+constexpr auto max_wait_v = std::numeric_limits<std::uint64_t>::max();
+
+using Ms = std::chrono::duration<float, std::milli>;
+
 Result<Glfw> makeGlfw(char const* title, uvec2 const extent, Instance::Flags const flags) noexcept {
 	if (detail::g_glfwData.window) { return Error::eDuplicateInstance; }
 	if (extent.x == 0U || extent.y == 0U) { return Error::eInvalidArg; }
@@ -37,6 +48,30 @@ uvec2 getFramebufferSize(GLFWwindow* const window) noexcept {
 	return {std::uint32_t(w), std::uint32_t(h)};
 }
 
+// refresh rate of the monitor the window is (mostly) on
+float refreshRate(GLFWwindow* const window) noexcept {
+	auto monitor = glfwGetWindowMonitor(window);
+	if (!monitor) {
+		int count{};
+		auto const monitors = glfwGetMonitors(&count);
+		ivec2 pos, size;
+		glfwGetWindowPos(window, &pos.x, &pos.y);
+		glfwGetWindowSize(window, &size.x, &size.y);
+		auto const centre = pos + size / ivec2{2, 2};
+		for (int i = 0; i < count && !monitor; ++i) {
+			auto const mode = glfwGetVideoMode(monitors[i]);
+			ivec2 origin;
+			glfwGetMonitorPos(monitors[i], &origin.x, &origin.y);
+			if (mode && centre.x >= origin.x && centre.y >= origin.y && centre.x < origin.x + mode->width && centre.y < origin.y + mode->height) {
+				monitor = monitors[i];
+			}
+		}
+	}
+	if (!monitor) { monitor = glfwGetPrimaryMonitor(); }
+	auto const mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+	return mode && mode->refreshRate > 0 ? float(mode->refreshRate) : 60.0f;
+}
+
 uvec2 getWindowSize(GLFWwindow* const window) noexcept {
 	int w{}, h{};
 	glfwGetWindowSize(window, &w, &h);
@@ -49,13 +84,18 @@ VKDevice initDevice(detail::VKInstance const& inst) noexcept {
 	ret.device = *inst.device;
 	ret.gpu = inst.gpu;
 	ret.queue = inst.queue;
+	ret.compute = inst.compute;
+	ret.features = inst.features;
+	ret.extensions = inst.extensions;
 	return ret;
 }
 
-FrameSync initFrameSync(vk::Device const device, std::uint32_t const queueFamily) {
+FrameSync initFrameSync(VKDevice const& vkd, std::size_t const workers) {
 	using CPCFB = vk::CommandPoolCreateFlagBits;
 	static constexpr vk::CommandPoolCreateFlags pool_flags_v = CPCFB::eTransient | CPCFB::eResetCommandBuffer;
 	static constexpr vk::CommandBufferLevel cb_lvl_v = vk::CommandBufferLevel::ePrimary;
+	auto const device = vkd.device;
+	auto const queueFamily = vkd.queue.family;
 	FrameSync ret;
 	for (std::size_t i = 0; i < FrameSync::frames_v; ++i) {
 		ret.sync[i].draw = device.createSemaphoreUnique({});
@@ -63,15 +103,22 @@ FrameSync initFrameSync(vk::Device const device, std::uint32_t const queueFamily
 		ret.sync[i].drawn = device.createFenceUnique({vk::FenceCreateFlagBits::eSignaled});
 		ret.sync[i].pool = device.createCommandPoolUnique(vk::CommandPoolCreateInfo(pool_flags_v, queueFamily));
 		ret.sync[i].cb = device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(*ret.sync[i].pool, cb_lvl_v, 1U)).front();
+		ret.sync[i].queries = detail::GpuQueries::make(vkd);
+		ret.sync[i].compute = detail::AsyncCompute::make(vkd);
+		for (std::size_t j = 0; j <= workers; ++j) {
+			auto& worker = ret.sync[i].workers.emplace_back();
+			worker.pool = device.createCommandPoolUnique(vk::CommandPoolCreateInfo(CPCFB::eTransient, queueFamily));
+			worker.cb = device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(*worker.pool, vk::CommandBufferLevel::eSecondary, 1U)).front();
+		}
 	}
 	return ret;
 }
 
-vk::UniqueRenderPass makeRenderPass(vk::Device device, vk::Format colour, bool autoTransition) {
+vk::UniqueRenderPass makeRenderPass(vk::Device device, vk::Format colour, vk::AttachmentLoadOp loadOp, bool autoTransition) {
 	vk::AttachmentDescription attachment;
 	attachment.format = colour;
 	attachment.samples = vk::SampleCountFlagBits::e1;
-	attachment.loadOp = vk::AttachmentLoadOp::eClear;
+	attachment.loadOp = loadOp;
 	attachment.storeOp = vk::AttachmentStoreOp::eStore;
 	attachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
 	attachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
@@ -109,33 +156,71 @@ vk::UniqueFramebuffer makeFramebuffer(vk::Device device, vk::RenderPass pass, de
 	return device.createFramebufferUnique(vk::FramebufferCreateInfo({}, pass, 1U, &target.view, target.extent.width, target.extent.height, 1U));
 }
 
-template <typename T, typename U = T>
-using TPair = std::pair<T, U>;
-
-struct ImageBarrier {
-	TPair<vk::AccessFlags> access;
-	TPair<vk::PipelineStageFlags> stages;
-	vk::CommandBuffer cb;
-	vk::Image image;
-
-	void operator()(TPair<vk::ImageLayout> const& layouts) const {
-		vk::ImageMemoryBarrier barrier;
-		barrier.oldLayout = layouts.first;
-		barrier.newLayout = layouts.second;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = image;
-		barrier.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-		barrier.subresourceRange.levelCount = 1U;
-		barrier.subresourceRange.layerCount = 1U;
-		barrier.srcAccessMask = access.first;
-		barrier.dstAccessMask = access.second;
-		cb.pipelineBarrier(stages.first, stages.second, {}, {}, {}, barrier);
+void beginRenderPass(vk::CommandBuffer cb, vk::RenderPass pass, vk::Framebuffer framebuffer, vk::Extent2D extent, vk::ClearValue const& clear) {
+	vk::RenderPassBeginInfo rpbi;
+	rpbi.renderPass = pass;
+	rpbi.framebuffer = framebuffer;
+	rpbi.renderArea.extent = extent;
+	rpbi.clearValueCount = 1U;
+	rpbi.pClearValues = &clear;
+	cb.beginRenderPass(rpbi, vk::SubpassContents::eInline);
+}
+
+void beginRendering(vk::CommandBuffer cb, detail::VKImage const& target, vk::AttachmentLoadOp loadOp, vk::ClearValue const& clear) {
+	vk::RenderingAttachmentInfo colour;
+	colour.imageView = target.view;
+	colour.imageLayout = vk::ImageLayout::eColorAttachmentOptimal;
+	colour.loadOp = loadOp;
+	colour.storeOp = vk::AttachmentStoreOp::eStore;
+	colour.clearValue = clear;
+	vk::RenderingInfo info;
+	info.renderArea.extent = target.extent;
+	info.layerCount = 1U;
+	info.colorAttachmentCount = 1U;
+	info.pColorAttachments = &colour;
+	cb.beginRendering(info);
+}
+
+void applySizeLimits(GLFWwindow* const window, WindowConfig const& config) noexcept {
+	auto const& min = config.minSize;
+	auto const& max = config.maxSize;
+	int const minX = min ? int(min->x) : GLFW_DONT_CARE;
+	int const maxX = max ? int(max->x) : GLFW_DONT_CARE;
+	int const minY = min ? int(min->y) : GLFW_DONT_CARE;
+	int const maxY = max ? int(max->y) : GLFW_DONT_CARE;
+	glfwSetWindowSizeLimits(window, minX, minY, maxX, maxY);
+}
+
+void applyIcon(GLFWwindow* const window, WindowConfig const& config) {
+	std::vector<GLFWimage> images;
+	images.reserve(config.icon.size());
+	for (std::size_t i = 0; i < config.icon.size(); ++i) {
+		auto const extent = config.iconExtents[i];
+		images.push_back(GLFWimage{int(extent.x), int(extent.y), const_cast<unsigned char*>(config.icon[i].data())});
+	}
+	glfwSetWindowIcon(window, int(images.size()), images.data());
+}
+
+Upscale upscaleSupport(vk::PhysicalDevice const gpu, vk::Format const format) {
+	using FFFB = vk::FormatFeatureFlagBits;
+	auto const features = gpu.getFormatProperties(format).optimalTilingFeatures;
+	auto ret = Upscale{format};
+	ret.blit = (features & FFFB::eBlitSrc) && (features & FFFB::eBlitDst);
+	if (features & FFFB::eSampledImageFilterLinear) { ret.filter = vk::Filter::eLinear; }
+	return ret;
+}
+
+// frames before the returned id have executed: drawn fences signal in submission order
+std::uint64_t executedFrames(vk::Device const device, FrameSync const& frameSync, std::uint64_t const begun) noexcept {
+	auto ret = begun;
+	for (auto const& sync : frameSync.sync) {
+		if (device.getFenceStatus(*sync.drawn) == vk::Result::eNotReady) { ret = std::min(ret, sync.frame); }
 	}
-};
+	return ret;
+}
 } // namespace
 
-std::span<std::string const> Event::fileDrop() const noexcept {
+std::span<std::pmr::string const> Event::fileDrop() const noexcept {
 	if (m_type == Type::eFileDrop && detail::g_glfwData.eventStorage && m_payload.index < detail::g_glfwData.eventStorage->drops.size()) {
 		return detail::g_glfwData.eventStorage->drops[m_payload.index];
 	}
@@ -148,6 +233,8 @@ Instance& Instance::operator=(Instance&&) noexcept = default;
 Instance::~Instance() noexcept {
 	if (m_impl) {
 		m_impl->device.device.waitIdle();
+		m_impl->tasks.clear();
+		m_impl->jobs.stop();
 		detail::g_glfwData = {};
 	}
 }
@@ -159,16 +246,55 @@ bool Instance::closing() const noexcept {
 
 Poll Instance::poll() noexcept {
 	EXPECT(m_impl);
+	DIBS_ZONE("dibs::poll");
+	{
+		// pace before sampling input, to keep input-to-present latency minimal
+		DIBS_ZONE("dibs::pace");
+		m_impl->timing.paced = m_impl->pacer.wait(m_impl->stats.pacing);
+	}
 	m_impl->events.clear();
 	m_impl->eventStorage = {};
+	// the previous frame's slot: the next Frame resets its own slot while these are still in use
+	m_impl->eventStorage.resource = &m_impl->arena.resource((m_impl->frameSync.index + FrameSync::frames_v - 1U) % FrameSync::frames_v);
 	glfwPollEvents();
 	auto const t = Clock::now();
 	Poll ret;
 	ret.dt = t - std::exchange(m_impl->elapsed, t);
 	ret.events = m_impl->events;
+	m_impl->tasks.poll(executedFrames(m_impl->device.device, m_impl->frameSync, m_impl->frameIds));
 	return ret;
 }
 
+Stats const& Instance::stats() const noexcept {
+	EXPECT(m_impl);
+	return m_impl->stats;
+}
+
+void Instance::spawn(Task task) {
+	EXPECT(m_impl && !task.done());
+	m_impl->tasks.spawn(std::exchange(task.m_handle, {}));
+}
+
+NextFrame Instance::nextFrame() const noexcept {
+	EXPECT(m_impl);
+	return NextFrame(m_impl->tasks);
+}
+
+GpuComplete Instance::gpuComplete(std::uint64_t const frame) const noexcept {
+	EXPECT(m_impl);
+	return GpuComplete(m_impl->tasks, frame);
+}
+
+Background Instance::background(ktl::kfunction<void()> work) const noexcept {
+	EXPECT(m_impl);
+	return Background(m_impl->tasks, std::move(work));
+}
+
+Jobs Instance::jobs() const noexcept {
+	EXPECT(m_impl);
+	return Jobs(m_impl->jobs);
+}
+
 uvec2 Instance::framebufferSize() const noexcept { return getFramebufferSize(m_impl->glfw.window); }
 uvec2 Instance::windowSize() const noexcept { return getWindowSize(m_impl->glfw.window); }
 std::string_view Instance::clipboard() const noexcept {
@@ -177,94 +303,375 @@ std::string_view Instance::clipboard() const noexcept {
 }
 void Instance::clipboard(std::string_view text) noexcept { glfwSetClipboardString(nullptr, text.data()); }
 void Instance::sizeLimits(std::optional<uvec2> min, std::optional<uvec2> max) noexcept {
-	int const minX = min ? int(min->x) : GLFW_DONT_CARE;
-	int const maxX = max ? int(max->x) : GLFW_DONT_CARE;
-	int const minY = min ? int(min->y) : GLFW_DONT_CARE;
-	int const maxY = max ? int(max->y) : GLFW_DONT_CARE;
-	glfwSetWindowSizeLimits(m_impl->glfw.window, minX, minY, maxX, maxY);
+	m_impl->window.minSize = min;
+	m_impl->window.maxSize = max;
+	applySizeLimits(m_impl->glfw.window, m_impl->window);
+}
+
+void Instance::pace(std::optional<float> const fps) noexcept {
+	EXPECT(m_impl);
+	m_impl->pace = fps;
+	auto const rate = fps ? (*fps > 0.0f ? *fps : refreshRate(m_impl->glfw.window)) : 0.0f;
+	auto const period = rate > 0.0f ? std::chrono::duration<float>(1.0f / rate) : std::chrono::duration<float>();
+	m_impl->pacer.period(std::chrono::duration_cast<Clock::duration>(period));
+	m_impl->stats.pacing = {};
+	m_impl->stats.pacing.targetMs = rate > 0.0f ? 1000.0f / rate : 0.0f;
+	if (rate > 0.0f) { log("Pacing frames to {} FPS", rate); }
+}
+
+void Instance::dynamicResolution(DynamicResolution const& config) noexcept {
+	EXPECT(m_impl);
+	m_impl->scaler.config(config);
+	if (config.budgetMs > 0.0f && !(m_impl->surface.info.imageUsage & vk::ImageUsageFlagBits::eTransferDst)) {
+		warn("Swapchain does not support transfer dst: dynamic resolution unavailable");
+	}
+}
+
+void Instance::uiRenderer(UiRenderer const renderer) {
+	EXPECT(m_impl && !m_impl->acquired);
+	m_impl->imgui.get().use(m_impl->device, renderer);
+}
+
+UiRenderer Instance::uiRenderer() const noexcept { return m_impl->imgui->renderer; }
+
+Result<uvec2> Instance::recreateWindow(std::string_view const title, uvec2 const extent, Flags const flags) {
+	EXPECT(m_impl && !m_impl->acquired);
+	DIBS_ZONE("dibs::recreate_window");
+	if (extent.x == 0U || extent.y == 0U) { return Error::eInvalidArg; }
+	auto const start = Clock::now();
+	auto impl = m_impl.get();
+	auto& vkd = impl->device;
+	// create the replacement first: nothing has changed if this fails
+	auto window = impl->glfw.instance->makeWindow(std::string(title).c_str(), extent, flags);
+	if (!window) { return Error::eWindowCreationFailure; }
+	VkSurfaceKHR rawSurface{};
+	if (glfwCreateWindowSurface(vkd.instance, window, nullptr, &rawSurface) != VK_SUCCESS) { return Error::eVulkanInitFailure; }
+	auto surface = vk::UniqueSurfaceKHR(vk::SurfaceKHR(rawSurface), vkd.instance);
+	if (!vkd.gpu.device.getSurfaceSupportKHR(vkd.queue.family, *surface)) { return Error::eVulkanInitFailure; }
+	auto formats = vkd.gpu.device.getSurfaceFormatsKHR(*surface);
+	vkd.device.waitIdle();
+	// render passes and Dear ImGui's pipelines are specific to the format: rebuilt before anything is replaced
+	auto const format = detail::imageFormat(formats);
+	if (format != impl->surface.info.imageFormat) {
+		auto renderPass = vk::UniqueRenderPass();
+		auto renderPassLoad = vk::UniqueRenderPass();
+		if (impl->renderPass) {
+			renderPass = makeRenderPass(vkd.device, format, vk::AttachmentLoadOp::eClear, false);
+			renderPassLoad = makeRenderPass(vkd.device, format, vk::AttachmentLoadOp::eLoad, false);
+		}
+		auto const& info = impl->surface.info;
+		auto const previous = detail::ImGuiInstance::Info{impl->glfw.window, *impl->renderPass, info.imageFormat, 2U, info.minImageCount};
+		auto const next = detail::ImGuiInstance::Info{impl->glfw.window, *renderPass, format, 2U, info.minImageCount};
+		if (!impl->imgui.get().rebuild(vkd, next, previous)) { return Error::ImGuiInitFailure; }
+		impl->renderPass = std::move(renderPass);
+		impl->renderPassLoad = std::move(renderPassLoad);
+	}
+	// the old swapchain (and any retired ones) must go before its surface, and the surface before its window
+	impl->deferQueue.clear();
+	for (auto& sync : impl->frameSync.sync) { sync.framebuffer.reset(); }
+	impl->surface.swapchain = {};
+	impl->vulkan.surface = std::move(surface);
+	impl->surface.surface = *impl->vulkan.surface;
+	vkd.gpu.formats = impl->vulkan.gpu.formats = std::move(formats);
+	impl->imgui->detach();
+	impl->glfw.window = std::move(window);
+	detail::g_glfwData.window = impl->glfw.window;
+	impl->imgui->attach(impl->glfw.window);
+	if (!centre(impl->glfw.window)) { log("Failed to centre window"); }
+	applySizeLimits(impl->glfw.window, impl->window);
+	if (impl->window.aspectRatio) { glfwSetWindowAspectRatio(impl->glfw.window, int(*impl->window.aspectRatio * 1000.0f), 1000); }
+	applyIcon(impl->glfw.window, impl->window);
+	// on failure the next Frame retries (and is unready until one succeeds)
+	auto const refreshed = impl->surface.refresh(vkd, getFramebufferSize(impl->glfw.window));
+	// the monitor may have changed
+	if (impl->pace && *impl->pace == 0.0f) { pace(impl->pace); }
+	if (!flags.test(Flag::eHidden)) { glfwShowWindow(impl->glfw.window); }
+	if (refreshed != vk::Result::eSuccess) { return Error::eVulkanInitFailure; }
+	log("Window recreated in {}ms", Ms(Clock::now() - start).count());
+	return framebufferSize();
+}
+
+void Instance::aspectRatio(float ratio) noexcept {
+	m_impl->window.aspectRatio = ratio;
+	glfwSetWindowAspectRatio(m_impl->glfw.window, int(ratio * 1000.0f), 1000);
 }
 
-void Instance::aspectRatio(float ratio) noexcept { glfwSetWindowAspectRatio(m_impl->glfw.window, int(ratio * 1000.0f), 1000); }
 void Instance::title(std::string_view utf8) noexcept { glfwSetWindowTitle(m_impl->glfw.window, utf8.data()); }
 
 void Instance::icon(std::span<const Bitmap> bitmaps) noexcept {
-	std::vector<GLFWimage> images;
-	images.reserve(bitmaps.size());
+	static constexpr std::uint32_t min_icon_v = 16U;
+	// copied: bitmaps need not outlive this call, and a recreated window gets the icon again
+	auto& config = m_impl->window;
+	config.icon.clear();
+	config.iconExtents.clear();
 	for (auto const bitmap : bitmaps) {
-		images.push_back(GLFWimage{int(bitmap.extent.x), int(bitmap.extent.y), const_cast<unsigned char*>(bitmap.bytes.data())});
+		config.icon.emplace_back(bitmap.bytes.begin(), bitmap.bytes.end());
+		config.iconExtents.push_back(bitmap.extent);
+	}
+	// a single bitmap: add box-filtered mips for the smaller sizes window managers request (taskbar, title bar)
+	if (bitmaps.size() == 1U) {
+		auto src = bitmaps.front();
+		while (src.extent.x >= 2U * min_icon_v && src.extent.y >= 2U * min_icon_v) {
+			auto const extent = pixels::halved(src.extent);
+			auto& mip = config.icon.emplace_back(std::size_t(extent.x) * extent.y * 4U);
+			pixels::downscale(src, mip);
+			config.iconExtents.push_back(extent);
+			src = {mip, extent};
+		}
 	}
-	glfwSetWindowIcon(m_impl->glfw.window, int(images.size()), images.data());
+	applyIcon(m_impl->glfw.window, config);
+}
+
+Frame Instance::tryFrame(std::chrono::nanoseconds const timeout, RGBA const clear) const {
+	return Frame(*this, clear, static_cast<std::uint64_t>(std::max(timeout.count(), std::chrono::nanoseconds::rep{})));
 }
 
-Frame::Frame(Instance const& instance, RGBA const clear) : m_clear(clear), m_instance(instance) {
+Frame::Frame(Instance const& instance, RGBA const clear) : Frame(instance, clear, max_wait_v) {}
+
+Frame::Frame(Instance const& instance, RGBA const clear, std::uint64_t const timeoutNs) : m_clear(clear), m_instance(instance) {
 	EXPECT(m_instance.m_impl && !m_instance.m_impl->acquired); // must not have already acquired an image
 	auto impl = m_instance.m_impl.get();
+	m_id = impl->frameIds++;
 	auto& sync = impl->frameSync.get();
+	auto& timing = impl->timing;
+	timing.start = Clock::now();
+	timing.sample = {};
+	timing.sample.paceMs = Ms(std::exchange(timing.paced, {})).count();
+	{
+		// wait for previous draw using this sync to complete
+		DIBS_ZONE("dibs::fence_wait");
+		impl->device.device.waitForFences(*sync.drawn, true, max_wait_v);
+		sync.compute.wait(impl->device);
+	}
+	for (auto& worker : sync.workers) {
+		impl->device.device.resetCommandPool(*worker.pool);
+		worker.recording = false;
+	}
+	impl->ring.reclaim(impl->frameSync.index, impl->stats.ring);
+	impl->arena.reclaim(impl->frameSync.index, impl->stats.arena);
+	if (impl->exporter) { impl->exporter->update(impl->frameSync.index, impl->stats.frameExport); }
+	impl->jobs.sample(impl->stats.workers);
+	impl->pipelines.sample(impl->stats.pipelines);
+	{
+		// footprint by subsystem, then heap budgets
+		auto& memory = impl->stats.memory;
+		memory.footprint.clear();
+		memory.footprint.push_back({"Swapchain", impl->surface.bytes(), 0U, true});
+		memory.footprint.push_back({"Retired (deferred)", impl->deferQueue.bytes(), 0U, true});
+		memory.footprint.push_back({"Frame graph", impl->graph.allocated(), 0U, false});
+		memory.footprint.push_back({"Frame ring", impl->stats.ring.capacity, 0U, false});
+		memory.footprint.push_back({"Dear ImGui", impl->imgui->bytes(), 0U, true});
+		memory.footprint.push_back({"Frame arena", 0U, impl->stats.arena.capacity, false});
+		memory.footprint.push_back({"Events", 0U, impl->events.capacity() * sizeof(Event), false});
+		memory.footprint.push_back({"Stats", 0U, sizeof(Stats), false});
+		std::uint64_t owned{};
+		for (auto const& each : memory.footprint) { owned += each.device; }
+		impl->memory.update(owned, memory);
+	}
+	// previous use of this sync has completed: its queries are available
+	if (auto gpu = sync.queries.collect(impl->device)) {
+		impl->stats.gpu.push(*gpu);
+		impl->scaler.update(gpu->ms);
+	}
+	if (impl->upscale.format != impl->surface.info.imageFormat) {
+		impl->upscale = upscaleSupport(impl->device.gpu.device, impl->surface.info.imageFormat);
+		if (!impl->upscale.blit) { log("Dynamic resolution unavailable: swapchain format cannot be blitted"); }
+	}
+	bool const scalable = impl->scaler.enabled() && impl->upscale.blit && (impl->surface.info.imageUsage & vk::ImageUsageFlagBits::eTransferDst);
+	impl->renderScale = scalable ? impl->scaler.scale() : 1.0f;
+	auto const waited = Clock::now();
+	timing.sample.fenceWaitMs = Ms(waited - timing.start).count();
 	// acquire next swapchain image to render to
-	impl->acquired = impl->surface.acquire(impl->device, *sync.draw, m_instance.framebufferSize());
+	bool timedOut{};
+	impl->acquired = impl->surface.acquire(impl->device, *sync.draw, m_instance.framebufferSize(), timeoutNs, timedOut);
+	timing.sample.acquireMs = Ms(Clock::now() - waited).count();
+	{
+		auto& acquire = impl->stats.acquire;
+		if (timedOut) { ++acquire.timeouts; }
+		if (impl->acquired) { ++acquire.acquired; }
+		acquire.lastWaitMs = timing.sample.acquireMs;
+		acquire.maxWaitMs = std::max(acquire.maxWaitMs, acquire.lastWaitMs);
+		// running mean over attempts that acquired or timed out (not swapchain refreshes)
+		if (timedOut || impl->acquired) {
+			acquire.meanWaitMs += (acquire.lastWaitMs - acquire.meanWaitMs) / static_cast<float>(acquire.acquired + acquire.timeouts);
+		}
+	}
+	if (impl->acquired) {
+		auto const& image = impl->acquired->image;
+		auto scene = std::optional<detail::RenderGraph::Scene>();
+		if (scalable) { scene = detail::RenderGraph::Scene{impl->surface.info.imageFormat, impl->renderScale}; }
+		impl->graph.begin({image.image, image.view, image.extent}, scene);
+		// start recording (Bridge::drawCmd)
+		sync.cb.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+		sync.queries.begin(sync.cb, impl->frames);
+	} else {
+		impl->graph.begin({});
+	}
 	impl->imgui->newFrame();
+	impl->tasks.frame(*this);
 }
 
 Frame::~Frame() {
 	auto impl = m_instance.m_impl.get();
+	// frame-phase jobs: eRecord before passes are recorded, eSubmit before the queue submission
+	impl->jobs.wait(JobPhase::eRecord);
+	if (!impl->acquired) { impl->jobs.wait(JobPhase::eSubmit); }
 	impl->imgui->endFrame();
+	auto& sync = impl->frameSync.get();
+	// submit async compute ahead of graphics
+	if (sync.compute.recording()) {
+		sync.compute.submit(impl->device, {});
+		impl->submits.external();
+	}
+	auto const computeWait = sync.compute.graphicsWait(impl->device);
 	if (impl->acquired) {
-		static constexpr auto max_wait_v = std::numeric_limits<std::uint64_t>::max();
-		auto& sync = impl->frameSync.get();
-		// wait for previous draw on this image to complete
-		impl->device.device.waitForFences(*sync.drawn, true, max_wait_v);
-		impl->device.device.resetFences(*sync.drawn);
-		// start recording
-		sync.cb.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
-		// transition image for shading
-		ImageBarrier ib;
-		ib.image = impl->acquired->image.image;
-		ib.cb = sync.cb;
-		ib.access = {{}, vk::AccessFlagBits::eColorAttachmentWrite};
-		ib.stages = {vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eColorAttachmentOutput};
-		ib({vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal});
-		// make framebuffer corresponding to current image
-		sync.framebuffer = makeFramebuffer(impl->device.device, *impl->renderPass, impl->acquired->image);
-		// perform render pass
 		m_clear.a = 0xff;
-		vk::ClearValue cv = vk::ClearColorValue(m_clear.array());
-		vk::RenderPassBeginInfo rpbi;
-		rpbi.renderPass = *impl->renderPass;
-		rpbi.framebuffer = *sync.framebuffer;
-		rpbi.renderArea.extent = impl->acquired->image.extent;
-		rpbi.clearValueCount = 1U;
-		rpbi.pClearValues = &cv;
-		sync.cb.beginRenderPass(rpbi, vk::SubpassContents::eInline);
-		impl->imgui->render(sync.cb);
-		sync.cb.endRenderPass();
-		// transition image for presentation
-		ib.access = {vk::AccessFlagBits::eColorAttachmentWrite, {}};
-		ib.stages = {vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eBottomOfPipe};
-		ib({vk::ImageLayout::eColorAttachmentOptimal, vk::ImageLayout::ePresentSrcKHR});
-		// stop recording
-		sync.cb.end();
-		// submit commands and present image
-		auto const res = impl->surface.submit(impl->device, sync.cb, {*sync.draw, *sync.present, *sync.drawn});
+		vk::ClearValue const cv = vk::ClearColorValue(m_clear.array());
+		auto const backbuffer = FrameGraph::Image{};
+		if (auto const scene = impl->graph.writtenScene()) {
+			// upscale the scene into the backbuffer; Dear ImGui is drawn over it at native resolution
+			FrameGraph::Access const upscale[] = {{*scene, FrameGraph::Use::eTransferSrc}, {backbuffer, FrameGraph::Use::eTransferDst}};
+			impl->graph.pass("dibs::upscale", upscale, [scene = *scene, backbuffer, filter = impl->upscale.filter](FrameGraph::Context const& pass) {
+				auto const src = pass.extent(scene), dst = pass.extent(backbuffer);
+				vk::ImageBlit region;
+				region.srcSubresource = region.dstSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0U, 0U, 1U);
+				region.srcOffsets[1] = vk::Offset3D(int(src.width), int(src.height), 1);
+				region.dstOffsets[1] = vk::Offset3D(int(dst.width), int(dst.height), 1);
+				auto const srcLayout = vk::ImageLayout::eTransferSrcOptimal, dstLayout = vk::ImageLayout::eTransferDstOptimal;
+				pass.cb().blitImage(pass.image(scene), srcLayout, pass.image(backbuffer), dstLayout, region, filter);
+			});
+		}
+		// draw Dear ImGui over any passes that wrote to the backbuffer, else over the clear colour
+		auto const loadOp = impl->graph.written(backbuffer) ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+		FrameGraph::Access const uiAccess[] = {{backbuffer, FrameGraph::Use::eColourAttachment}};
+		impl->graph.pass("dibs::imgui", uiAccess, [impl, &sync, cv, loadOp](FrameGraph::Context const& pass) {
+			auto const& image = impl->acquired->image;
+			sync.queries.imgui(pass.cb());
+			if (impl->renderPass) {
+				// make framebuffer corresponding to current image and perform render pass
+				auto const rp = loadOp == vk::AttachmentLoadOp::eLoad ? *impl->renderPassLoad : *impl->renderPass;
+				sync.framebuffer = makeFramebuffer(impl->device.device, rp, image);
+				beginRenderPass(pass.cb(), rp, *sync.framebuffer, image.extent, cv);
+				impl->imgui->render(pass.cb(), impl->ring, impl->frameSync.index);
+				pass.cb().endRenderPass();
+			} else {
+				// render directly to swapchain image view
+				beginRendering(pass.cb(), image, loadOp, cv);
+				impl->imgui->render(pass.cb(), impl->ring, impl->frameSync.index);
+				pass.cb().endRendering();
+			}
+		});
+		vk::PipelineStageFlags wait;
+		{
+			// record all passes, transitioning image for presentation
+			DIBS_ZONE("dibs::record");
+			// commands recorded by jobs (Bridge::workerCmd), in worker order, after drawCmd
+			ktl::fixed_vector<vk::CommandBuffer, max_workers_v + 1U> secondary;
+			for (auto& worker : sync.workers) {
+				if (!std::exchange(worker.recording, false)) { continue; }
+				worker.cb.end();
+				secondary.push_back(worker.cb);
+			}
+			if (!secondary.empty()) { sync.cb.executeCommands(std::uint32_t(secondary.size()), secondary.data()); }
+			wait = impl->graph.record(impl->device, sync.cb, vk::ImageLayout::ePresentSrcKHR, impl->deferQueue);
+			if (impl->exporter && (impl->surface.info.imageUsage & detail::FrameExporter::src_usage_v)) {
+				auto const& image = impl->acquired->image;
+				impl->exporter->record(sync.cb, image, impl->surface.info.imageFormat, impl->frameSync.index, m_id, impl->submits);
+			}
+			sync.queries.end(sync.cb);
+			// stop recording
+			sync.cb.end();
+		}
+		impl->jobs.wait(JobPhase::eSubmit);
+		// submit commands (with Bridge::submit batches) and present image
+		ktl::fixed_vector<VKWait, 2> waits;
+		waits.push_back({*sync.draw, wait});
+		if (computeWait.semaphore) { waits.push_back({computeWait.semaphore, computeWait.stages}); }
+		// queue family ownership acquires, if any, before the frame's commands
+		vk::CommandBuffer const cbs[] = {computeWait.acquire, sync.cb};
+		auto const present = *sync.present;
+		auto frame = VKSubmit{};
+		frame.commandBuffers = computeWait.acquire ? std::span<vk::CommandBuffer const>(cbs) : std::span<vk::CommandBuffer const>(cbs).subspan(1U);
+		frame.waits = {waits.data(), waits.size()};
+		frame.signals = {&present, 1U};
+		impl->device.device.resetFences(*sync.drawn);
+		auto const res = impl->submits.flush(impl->device, frame, *sync.drawn);
+		impl->submits.sample(impl->stats.submits, impl->device.features.test(VKFeature::eSynchronization2));
 		EXPECT(res == vk::Result::eSuccess);
 		if (res != vk::Result::eSuccess) { return; }
+		if (impl->exporter) { impl->exporter->submitted(); }
+		sync.frame = m_id;
+		++impl->frames;
+		auto const presenting = Clock::now();
 		auto const pres = impl->surface.present(impl->device, *impl->acquired, *sync.present, m_instance.framebufferSize());
 		EXPECT(pres);
+		auto const presented = Clock::now();
+		// record frame timings
+		auto& timing = impl->timing;
+		auto& sample = timing.sample;
+		sample.frame = impl->frames - 1U;
+		sample.presentMs = Ms(presented - presenting).count();
+		sample.cpuMs = Ms(presented - timing.start).count() - sample.fenceWaitMs - sample.acquireMs - sample.presentMs;
+		if (timing.end != Clock::time_point{}) { sample.outsideMs = Ms(timing.start - timing.end).count() - sample.paceMs; }
+		if (timing.present != Clock::time_point{}) {
+			sample.intervalMs = Ms(presented - timing.present).count();
+			impl->stats.frames.record(sample);
+		}
+		timing.present = presented;
 		// swap buffers
 		impl->frameSync.next();
 		impl->deferQueue.next();
 		// reset acquired image (submitted to presentation engine)
 		impl->acquired.reset();
+	} else {
+		if (computeWait.semaphore || !impl->submits.empty()) {
+			// nothing to draw: still submit Bridge::submit batches, and consume the compute semaphore (and any ownership transfers)
+			// so it can be signalled again
+			auto const computed = VKWait{computeWait.semaphore, computeWait.stages};
+			auto frame = VKSubmit{};
+			if (computeWait.semaphore) { frame.waits = {&computed, 1U}; }
+			if (computeWait.acquire) { frame.commandBuffers = {&computeWait.acquire, 1U}; }
+			impl->device.device.resetFences(*sync.drawn);
+			auto const res = impl->submits.flush(impl->device, frame, *sync.drawn);
+			EXPECT(res == vk::Result::eSuccess);
+			sync.frame = m_id;
+		}
+		impl->submits.sample(impl->stats.submits, impl->device.features.test(VKFeature::eSynchronization2));
+	}
+	impl->timing.end = Clock::now();
+	if (impl->statsExporter) {
+		auto const now = std::chrono::duration_cast<std::chrono::nanoseconds>(impl->timing.end.time_since_epoch());
+		impl->statsExporter->publish(impl->stats, impl->surface.recreations, impl->events.size(), static_cast<std::uint64_t>(now.count()));
 	}
 }
 
 bool Frame::ready() const noexcept { return m_instance.m_impl->acquired.has_value(); }
 
+FrameGraph Frame::graph() const noexcept { return FrameGraph(m_instance.m_impl->graph); }
+
+std::pmr::memory_resource& Frame::arena() const noexcept {
+	auto impl = m_instance.m_impl.get();
+	return impl->arena.resource(impl->frameSync.index);
+}
+
 uvec2 Frame::extent() const noexcept {
 	auto const ret = m_instance.m_impl->surface.info.imageExtent;
 	return {ret.width, ret.height};
 }
 
+uvec2 Frame::renderExtent() const noexcept {
+	auto const ret = m_instance.m_impl->surface.info.imageExtent;
+	auto const scale = m_instance.m_impl->renderScale;
+	return {std::max(std::uint32_t(float(ret.width) * scale + 0.5f), 1U), std::max(std::uint32_t(float(ret.height) * scale + 0.5f), 1U)};
+}
+
+float Frame::renderScale() const noexcept { return m_instance.m_impl->renderScale; }
+float Frame::budgetMs() const noexcept { return m_instance.m_impl->scaler.config().budgetMs; }
+
 Result<Instance> Instance::Builder::operator()() const {
+	if constexpr (profile::enabled_v) {
+		if (auto const path = std::getenv("DIBS_PROFILE_OUT")) { profile::exportTraceOnExit(path); }
+	}
 	auto glfw = makeGlfw(m_title.data(), m_extent, m_flags);
 	if (!glfw) { return glfw.error(); }
 	auto makeSurface = [&glfw](vk::Instance inst) {
@@ -272,15 +679,26 @@ Result<Instance> Instance::Builder::operator()() const {
 		glfwCreateWindowSurface(inst, glfw->window, nullptr, &ret);
 		return vk::SurfaceKHR(ret);
 	};
-	auto vulkan = detail::VKInstance::make(std::move(makeSurface), detail::VKInstance::Flag::eValidation);
+	detail::GpuRequest request{m_required, m_desired, m_requiredExtensions, m_desiredExtensions, m_gpu};
+	if (!m_export.socket.empty()) {
+		request.desiredExtensions.push_back(VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME);
+		request.desiredExtensions.push_back(VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME);
+	}
+	if (auto const select = std::getenv("DIBS_GPU")) { request.select = select; }
+	auto vulkan = detail::VKInstance::make(std::move(makeSurface), detail::VKInstance::Flag::eValidation, request);
 	if (!vulkan) { return vulkan.error(); }
 	if (!centre(glfw->window)) { log("Failed to centre window"); }
 	auto const vkd = initDevice(*vulkan);
 	detail::VKSurface surface;
 	surface.surface = *vulkan->surface;
+	if (!m_export.socket.empty()) { surface.usage = detail::FrameExporter::src_usage_v; }
 	if (surface.refresh(vkd, getFramebufferSize(glfw->window)) != vk::Result::eSuccess) { return Error::eVulkanInitFailure; }
-	auto renderPass = makeRenderPass(vkd.device, surface.info.imageFormat, false);
-	auto imgui = detail::ImGuiInstance::make(vkd, {glfw->window, *renderPass, 2U, surface.info.minImageCount});
+	vk::UniqueRenderPass renderPass, renderPassLoad;
+	if (!vkd.features.test(VKFeature::eDynamicRendering)) {
+		renderPass = makeRenderPass(vkd.device, surface.info.imageFormat, vk::AttachmentLoadOp::eClear, false);
+		renderPassLoad = makeRenderPass(vkd.device, surface.info.imageFormat, vk::AttachmentLoadOp::eLoad, false);
+	}
+	auto imgui = detail::ImGuiInstance::make(vkd, {glfw->window, *renderPass, surface.info.imageFormat, 2U, surface.info.minImageCount});
 	if (!imgui) { return Error::ImGuiInitFailure; }
 	// all checks passed
 	log("Using GPU: {}", std::string(vulkan->gpu.properties.deviceName.begin(), vulkan->gpu.properties.deviceName.end()));
@@ -290,12 +708,30 @@ Result<Instance> Instance::Builder::operator()() const {
 	impl->device = vkd;
 	impl->surface = std::move(surface);
 	impl->surface.deferQueue = &impl->deferQueue;
-	impl->frameSync = initFrameSync(vkd.device, vkd.queue.family);
+	impl->jobs.start(m_jobs);
+	impl->tasks.jobs(impl->jobs);
+	impl->frameSync = initFrameSync(vkd, impl->jobs.workers());
+	impl->ring.init(impl->device);
+	impl->arena.init();
+	impl->pipelines.init(impl->device, impl->jobs);
+	impl->memory.init(impl->device);
+	impl->exporter = detail::FrameExporter::make(impl->device, m_export, impl->deferQueue);
+	auto const statsShm = std::getenv("DIBS_STATS_SHM");
+	impl->statsExporter = detail::StatsExporter::make(statsShm ? statsShm : m_statsShm);
+	if (impl->exporter && !(impl->surface.info.imageUsage & detail::FrameExporter::src_usage_v)) {
+		warn("Swapchain does not support transfer src: frames will not be exported");
+	}
 	impl->renderPass = std::move(renderPass);
+	impl->renderPassLoad = std::move(renderPassLoad);
 	impl->imgui = std::move(imgui);
+	impl->stats.frames = FrameStats(m_frameBudgets);
 	impl->events.reserve(512U);
 	detail::g_glfwData = {impl->glfw.window, &impl->events, &impl->eventStorage};
 	if (!m_flags.test(Flag::eHidden)) { glfwShowWindow(impl->glfw.window); }
-	return Instance(std::move(impl));
+	auto ret = Instance(std::move(impl));
+	ret.pace(m_pace);
+	ret.dynamicResolution(m_dynamicResolution);
+	ret.uiRenderer(m_uiRenderer);
+	return ret;
 }
 } // namespace dibs
@@ -0,0 +1,16 @@
+#include <detail/render_graph.hpp>
+#include <dibs/frame_graph.hpp>
+
+namespace dibs {
+FrameGraph::Image FrameGraph::scene() { return m_graph->scene(); }
+FrameGraph::Image FrameGraph::transient(Transient const& desc) { return m_graph->transient(desc); }
+
+FrameGraph& FrameGraph::pass(std::string name, std::span<Access const> accesses, Record record) {
+	m_graph->pass(std::move(name), accesses, std::move(record));
+	return *this;
+}
+
+vk::Image FrameGraph::Context::image(Image const image) const noexcept { return m_graph->target(image).image; }
+vk::ImageView FrameGraph::Context::view(Image const image) const noexcept { return m_graph->target(image).view; }
+vk::Extent2D FrameGraph::Context::extent(Image const image) const noexcept { return m_graph->target(image).extent; }
+} // namespace dibs
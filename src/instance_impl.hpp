@@ -1,10 +1,25 @@
 #pragma once
+#include <detail/async_compute.hpp>
+#include <detail/frame_arena.hpp>
 #include <detail/defer_queue.hpp>
+#include <detail/frame_exporter.hpp>
+#include <detail/frame_pacer.hpp>
+#include <detail/frame_ring.hpp>
+#include <detail/gpu_queries.hpp>
 #include <detail/glfw_instance.hpp>
 #include <detail/imgui_instance.hpp>
+#include <detail/job_system.hpp>
+#include <detail/memory_monitor.hpp>
+#include <detail/pipeline_service.hpp>
+#include <detail/render_graph.hpp>
+#include <detail/resolution_scaler.hpp>
+#include <detail/stats_exporter.hpp>
+#include <detail/submit_batch.hpp>
+#include <detail/task_scheduler.hpp>
 #include <detail/vk_instance.hpp>
 #include <detail/vk_surface.hpp>
 #include <dibs/dibs.hpp>
+#include <dibs/stats.hpp>
 #include <ktl/fixed_vector.hpp>
 
 namespace dibs {
@@ -16,7 +31,14 @@ struct Glfw {
 };
 
 struct FrameSync {
-	static constexpr std::size_t frames_v = 2U;
+	static constexpr std::size_t frames_v = frames_in_flight_v;
+
+	// Bridge::workerCmd
+	struct Secondary {
+		vk::UniqueCommandPool pool;
+		vk::CommandBuffer cb;
+		bool recording{};
+	};
 
 	struct Sync {
 		vk::UniqueSemaphore draw;
@@ -25,6 +47,10 @@ struct FrameSync {
 		vk::UniqueCommandPool pool;
 		vk::CommandBuffer cb;
 		vk::UniqueFramebuffer framebuffer;
+		detail::GpuQueries queries;
+		detail::AsyncCompute compute;
+		std::uint64_t frame{}; // Frame::id last submitted with drawn
+		std::vector<Secondary> workers; // per job worker, then one for any other thread
 	};
 
 	Sync sync[frames_v];
@@ -34,10 +60,36 @@ struct FrameSync {
 	void next() noexcept { index = (index + 1) % frames_v; }
 };
 
+// CPU timestamps for FrameStats
+struct FrameTiming {
+	Clock::time_point start{};	 // current Frame
+	Clock::time_point end{};	 // previous Frame
+	Clock::time_point present{}; // previous present
+	Clock::duration paced{};	 // in the last poll()
+	FrameSample sample;
+};
+
+// Instance::sizeLimits / aspectRatio / icon: re-applied to a recreated window
+struct WindowConfig {
+	std::optional<uvec2> minSize;
+	std::optional<uvec2> maxSize;
+	std::optional<float> aspectRatio;
+	std::vector<std::vector<std::uint8_t>> icon; // RGBA8 copies, including generated mips
+	std::vector<uvec2> iconExtents;
+};
+
+// dynamic resolution: blitting the scene into the backbuffer, checked once per swapchain format
+struct Upscale {
+	vk::Format format{};
+	bool blit{};
+	vk::Filter filter{vk::Filter::eNearest};
+};
+
 namespace detail {
 struct EventStorage {
-	using Drop = std::vector<std::string>;
+	using Drop = std::pmr::vector<std::pmr::string>;
 	ktl::fixed_vector<Drop, 4> drops;
+	std::pmr::memory_resource* resource{std::pmr::get_default_resource()}; // payloads
 };
 } // namespace detail
 
@@ -47,12 +99,33 @@ struct Instance::Impl {
 	VKDevice device;
 	detail::VKSurface surface;
 	FrameSync frameSync;
+	detail::FrameRing ring;
+	detail::FrameArena arena; // before eventStorage: holds its payloads
 	detail::DeferQueue deferQueue;
 	vk::UniqueRenderPass renderPass;
+	vk::UniqueRenderPass renderPassLoad;
+	detail::RenderGraph graph;
+	detail::SubmitBatch submits;
 	detail::UniqueImGui imgui;
 	std::vector<Event> events;
 	detail::EventStorage eventStorage;
 	std::optional<detail::VKSurface::Acquire> acquired;
+	Stats stats;
+	FrameTiming timing;
+	detail::FramePacer pacer;
+	detail::ResolutionScaler scaler;
+	detail::MemoryMonitor memory;
+	std::unique_ptr<detail::FrameExporter> exporter; // Builder::exportFrames
+	std::unique_ptr<detail::StatsExporter> statsExporter; // Builder::exportStats
+	std::optional<float> pace; // Instance::pace: 0 follows the window's monitor
+	WindowConfig window;
+	Upscale upscale; // of the swapchain format
+	float renderScale{1.0f}; // this frame
+	std::uint64_t frames{}; // submitted
+	std::uint64_t frameIds{}; // constructed
 	Clock::time_point elapsed = Clock::now();
+	detail::PipelineService pipelines; // after jobs have stopped
+	detail::JobSystem jobs;
+	detail::TaskScheduler tasks; // last: suspended coroutines are destroyed first
 };
 } // namespace dibs
@@ -0,0 +1,15 @@
+#include <detail/job_system.hpp>
+#include <dibs/jobs.hpp>
+
+namespace dibs {
+bool JobHandle::done() const noexcept { return !m_state || m_state->pending.load(std::memory_order_acquire) == 0U; }
+
+JobHandle Jobs::push(Work work, JobPhase const phase) { return m_system->push(std::move(work), phase); }
+
+void Jobs::wait(JobHandle const& handle) {
+	if (handle.m_state) { m_system->wait(*handle.m_state); }
+}
+
+std::size_t Jobs::workers() const noexcept { return m_system->workers(); }
+std::size_t Jobs::thread() const noexcept { return m_system->thread(); }
+} // namespace dibs
@@ -0,0 +1,16 @@
+#include <detail/pipeline_service.hpp>
+#include <dibs/pipelines.hpp>
+
+namespace dibs {
+vk::Pipeline VKPipeline::get() const noexcept {
+	if (!m_entry) { return {}; }
+	auto const state = m_entry->state.load(std::memory_order_acquire);
+	if (state == detail::PipelineEntry::State::eReady) { return m_entry->pipeline; }
+	if (state == detail::PipelineEntry::State::ePending) { m_entry->notReady->fetch_add(1U, std::memory_order_relaxed); }
+	return {};
+}
+
+bool VKPipeline::ready() const noexcept { return m_entry && m_entry->state.load(std::memory_order_acquire) == detail::PipelineEntry::State::eReady; }
+
+bool VKPipeline::failed() const noexcept { return m_entry && m_entry->state.load(std::memory_order_acquire) == detail::PipelineEntry::State::eFailed; }
+} // namespace dibs
@@ -0,0 +1,85 @@
+#include <detail/expect.hpp>
+#include <detail/pixel_kernels.hpp>
+#include <dibs/pixels.hpp>
+#include <algorithm>
+#include <atomic>
+
+namespace dibs {
+namespace {
+struct Dispatch {
+	SimdLevel best = detail::detectSimd();
+	std::atomic<SimdLevel> level = best;
+	// one table per level, selected by index
+	detail::PixelKernels kernels[4] = {
+		detail::pixelKernels(SimdLevel::eScalar),
+		detail::pixelKernels(SimdLevel::eSse2),
+		detail::pixelKernels(SimdLevel::eAvx2),
+		detail::pixelKernels(SimdLevel::eNeon),
+	};
+
+	static Dispatch& instance() noexcept {
+		static Dispatch s_dispatch;
+		return s_dispatch;
+	}
+
+	detail::PixelKernels const& get() const noexcept { return kernels[static_cast<std::size_t>(level.load(std::memory_order_relaxed))]; }
+};
+
+detail::PixelKernels const& kernels() noexcept { return Dispatch::instance().get(); }
+
+constexpr std::size_t pixelCount(std::size_t const bytes) noexcept { return bytes / 4U; }
+} // namespace
+
+SimdLevel pixels::simd() noexcept { return Dispatch::instance().level.load(); }
+
+SimdLevel pixels::simd(SimdLevel const max) noexcept {
+	auto& dispatch = Dispatch::instance();
+	auto const supported = [best = dispatch.best](SimdLevel const level) {
+		return level == SimdLevel::eScalar || level == best || (level == SimdLevel::eSse2 && best == SimdLevel::eAvx2);
+	};
+	auto ret = max;
+	if (!supported(ret)) { ret = max == SimdLevel::eAvx2 && supported(SimdLevel::eSse2) ? SimdLevel::eSse2 : SimdLevel::eScalar; }
+	dispatch.level.store(ret);
+	return ret;
+}
+
+void pixels::swizzle(std::span<std::uint8_t const> const src, std::span<std::uint8_t> const dst) noexcept {
+	EXPECT(src.size() % 4U == 0 && dst.size() >= src.size());
+	kernels().swizzle(src.data(), dst.data(), pixelCount(src.size()));
+}
+
+void pixels::pack(std::span<float const> const src, std::span<std::uint8_t> const dst) noexcept {
+	EXPECT(dst.size() >= src.size());
+	kernels().pack(src.data(), dst.data(), src.size());
+}
+
+void pixels::srgbToLinear(std::span<std::uint8_t const> const src, std::span<float> const dst) noexcept {
+	EXPECT(src.size() % 4U == 0 && dst.size() >= src.size());
+	kernels().srgbToLinear(src.data(), dst.data(), pixelCount(src.size()));
+}
+
+void pixels::premultiply(std::span<std::uint8_t const> const src, std::span<std::uint8_t> const dst) noexcept {
+	EXPECT(src.size() % 4U == 0 && dst.size() >= src.size());
+	kernels().premultiply(src.data(), dst.data(), pixelCount(src.size()));
+}
+
+void pixels::downscale(Bitmap const& src, std::span<std::uint8_t> const dst) noexcept {
+	auto const extent = halved(src.extent);
+	std::size_t const srcStride = std::size_t(src.extent.x) * 4U;
+	std::size_t const dstStride = std::size_t(extent.x) * 4U;
+	EXPECT(src.bytes.size() >= srcStride * src.extent.y && dst.size() >= dstStride * extent.y);
+	if (src.extent.x == 0 || src.extent.y == 0) { return; }
+	auto const& k = kernels();
+	for (std::uint32_t y = 0; y < extent.y; ++y) {
+		auto const* row0 = src.bytes.data() + std::size_t(y) * 2U * srcStride;
+		// a single source row is averaged with itself
+		auto const* row1 = src.extent.y > 1U ? row0 + srcStride : row0;
+		auto* out = dst.data() + std::size_t(y) * dstStride;
+		if (src.extent.x > 1U) {
+			k.downscaleRow(row0, row1, out, extent.x);
+		} else {
+			for (std::size_t c = 0; c < 4U; ++c) { out[c] = static_cast<std::uint8_t>((unsigned(row0[c]) + row1[c] + 1U) >> 1U); }
+		}
+	}
+}
+} // namespace dibs
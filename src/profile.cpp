@@ -0,0 +1,148 @@
+#include <dibs/profile.hpp>
+
+#if defined(DIBS_PROFILE)
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dibs::profile {
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Event {
+	char const* name{};
+	std::int64_t start{};
+	std::int64_t end{};
+};
+
+// single-writer ring per thread: the owner only ever stores, exporters read behind the published count
+struct Buffer {
+	static constexpr std::size_t capacity_v = 1U << 15U;
+
+	std::array<Event, capacity_v> events;
+	std::atomic<std::uint64_t> count{};
+	std::atomic<char const*> name{};
+	std::uint32_t tid{};
+};
+
+struct Registry {
+	static Registry& instance() {
+		static Registry s_registry;
+		return s_registry;
+	}
+
+	std::shared_ptr<Buffer> add() {
+		auto ret = std::make_shared<Buffer>();
+		auto lock = std::scoped_lock(mutex);
+		ret->tid = std::uint32_t(buffers.size()) + 1U;
+		buffers.push_back(ret);
+		return ret;
+	}
+
+	std::vector<std::shared_ptr<Buffer>> snapshot() {
+		auto lock = std::scoped_lock(mutex);
+		return buffers;
+	}
+
+	Clock::time_point const epoch = Clock::now();
+	std::mutex mutex; // registration and export only
+	std::vector<std::shared_ptr<Buffer>> buffers; // kept alive past thread exit
+	std::string exitPath;
+	bool exitRegistered{};
+};
+
+Buffer& buffer() {
+	// registry outlives every thread_local handle (constructed first)
+	thread_local auto const t_buffer = Registry::instance().add();
+	return *t_buffer;
+}
+
+std::int64_t now() noexcept { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - Registry::instance().epoch).count(); }
+
+void push(Event const& event) noexcept {
+	auto& buf = buffer();
+	auto const i = buf.count.load(std::memory_order_relaxed);
+	// the previous count store is visible before this slot changes: an exporter that read the old count can tell it is stale
+	std::atomic_thread_fence(std::memory_order_release);
+	buf.events[i % Buffer::capacity_v] = event;
+	buf.count.store(i + 1U, std::memory_order_release);
+}
+
+void writeName(std::FILE* file, char const* name) {
+	for (; *name; ++name) {
+		auto const c = *name;
+		if (c == '"' || c == '\\') { std::fputc('\\', file); }
+		if (static_cast<unsigned char>(c) >= 0x20) { std::fputc(c, file); }
+	}
+}
+
+void exitHandler() { exportTrace(Registry::instance().exitPath.c_str()); }
+} // namespace
+
+Zone::Zone(char const* name) noexcept : m_name(name), m_start(now()) {}
+Zone::~Zone() noexcept { push({m_name, m_start, now()}); }
+
+void threadName(char const* name) noexcept { buffer().name.store(name); }
+
+bool exportTrace(char const* path) {
+	if (!path || !*path) { return false; }
+	auto* file = std::fopen(path, "w");
+	if (!file) { return false; }
+	std::vector<Event> events;
+	std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+	bool first = true;
+	auto const separator = [&] {
+		if (!first) { std::fputs(",\n", file); }
+		first = false;
+	};
+	for (auto const& buf : Registry::instance().snapshot()) {
+		if (auto const name = buf->name.load()) {
+			separator();
+			std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", buf->tid);
+			writeName(file, name);
+			std::fputs("\"}}", file);
+		}
+		// copy the live window, then discard anything the owner may have overwritten meanwhile: every slot up to the published
+		// count, plus the one it may be writing (count itself)
+		auto const end = buf->count.load(std::memory_order_acquire);
+		auto const begin = end > Buffer::capacity_v ? end - Buffer::capacity_v : 0U;
+		events.clear();
+		for (auto i = begin; i < end; ++i) { events.push_back(buf->events[i % Buffer::capacity_v]); }
+		std::atomic_thread_fence(std::memory_order_acquire);
+		auto const after = buf->count.load(std::memory_order_relaxed) + 1U;
+		auto const valid = after > Buffer::capacity_v ? after - Buffer::capacity_v : 0U;
+		auto const skip = std::size_t(std::min(std::max(valid, begin) - begin, end - begin));
+		for (auto it = events.begin() + std::ptrdiff_t(skip); it != events.end(); ++it) {
+			separator();
+			std::fputs("{\"name\":\"", file);
+			writeName(file, it->name);
+			std::fprintf(file, "\",\"cat\":\"dibs\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", buf->tid, double(it->start) / 1000.0,
+						 double(it->end - it->start) / 1000.0);
+		}
+	}
+	std::fputs("\n]}\n", file);
+	return std::fclose(file) == 0;
+}
+
+void exportTraceOnExit(char const* path) {
+	auto& registry = Registry::instance();
+	auto lock = std::scoped_lock(registry.mutex);
+	registry.exitPath = path ? path : "";
+	if (!std::exchange(registry.exitRegistered, true)) { std::atexit(&exitHandler); }
+}
+} // namespace dibs::profile
+#else
+namespace dibs::profile {
+void threadName(char const*) noexcept {}
+bool exportTrace(char const*) { return false; }
+void exportTraceOnExit(char const*) {}
+} // namespace dibs::profile
+#endif
@@ -0,0 +1,221 @@
+#include <imgui.h>
+#include <dibs/stats.hpp>
+#include <ktl/kformat.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace dibs {
+namespace {
+constexpr std::uint64_t stutter_warmup_v = 8U;
+constexpr float average_weight_v = 0.1f;
+
+float gpuMs(void* data, int index) { return (*static_cast<decltype(Stats::gpu) const*>(data))[std::size_t(index)].ms; }
+
+Phase cause(FrameSample const& sample) noexcept {
+	std::pair<Phase, float> const phases[] = {
+		{Phase::eOutside, sample.outsideMs}, {Phase::eCpu, sample.cpuMs},		  {Phase::eFenceWait, sample.fenceWaitMs},
+		{Phase::eAcquire, sample.acquireMs}, {Phase::ePresent, sample.presentMs},
+	};
+	auto const less = [](auto const& a, auto const& b) { return a.second < b.second; };
+	return std::max_element(std::begin(phases), std::end(phases), less)->first;
+}
+} // namespace
+
+FrameStats::FrameStats(std::span<float const> budgets) noexcept {
+	m_budgetCount = std::min(budgets.size(), max_budgets_v);
+	std::copy_n(budgets.begin(), m_budgetCount, m_budgets.begin());
+}
+
+void FrameStats::record(FrameSample const& sample) noexcept {
+	m_samples.push(sample);
+	for (std::size_t i = 0; i < m_budgetCount; ++i) {
+		if (sample.intervalMs > m_budgets[i]) { ++m_overBudget[i]; }
+	}
+	if (m_frames++ == 0U) {
+		m_average = sample.intervalMs;
+	} else if (m_frames > stutter_warmup_v && sample.intervalMs > stutter_factor_v * m_average) {
+		// stutters are kept out of the average so a burst of them is still reported
+		m_stutters.push({sample.frame, sample.intervalMs, m_average, cause(sample)});
+		++m_stutterCount;
+	} else {
+		m_average += average_weight_v * (sample.intervalMs - m_average);
+	}
+}
+
+float FrameStats::mean(Metric const metric) const noexcept {
+	if (m_samples.empty()) { return 0.0f; }
+	float sum{};
+	for (std::size_t i = 0; i < m_samples.size(); ++i) { sum += get(m_samples[i], metric); }
+	return sum / float(m_samples.size());
+}
+
+float FrameStats::percentile(Metric const metric, float const p) const noexcept {
+	if (m_samples.empty()) { return 0.0f; }
+	std::array<float, decltype(m_samples)::capacity_v> values;
+	auto const count = m_samples.size();
+	for (std::size_t i = 0; i < count; ++i) { values[i] = get(m_samples[i], metric); }
+	auto const rank = std::min(std::size_t(std::clamp(p, 0.0f, 1.0f) * float(count - 1U) + 0.5f), count - 1U);
+	auto const nth = values.begin() + std::ptrdiff_t(rank);
+	std::nth_element(values.begin(), nth, values.begin() + std::ptrdiff_t(count));
+	return *nth;
+}
+
+FrameStats::Histogram FrameStats::histogram(Metric const metric) const noexcept {
+	Histogram ret{};
+	for (std::size_t i = 0; i < m_samples.size(); ++i) {
+		auto const bin = std::size_t(std::max(get(m_samples[i], metric), 0.0f) / bin_ms_v);
+		++ret[std::min(bin, bins_v - 1U)];
+	}
+	return ret;
+}
+
+float FrameStats::fps() const noexcept {
+	auto const ms = mean(Metric::eInterval);
+	return ms > 0.0f ? 1000.0f / ms : 0.0f;
+}
+
+float FrameStats::get(FrameSample const& sample, Metric const metric) noexcept {
+	switch (metric) {
+	case Metric::eInterval: return sample.intervalMs;
+	case Metric::eOutside: return sample.outsideMs;
+	case Metric::eCpu: return sample.cpuMs;
+	case Metric::eFenceWait: return sample.fenceWaitMs;
+	case Metric::eAcquire: return sample.acquireMs;
+	case Metric::ePresent: return sample.presentMs;
+	case Metric::ePace: return sample.paceMs;
+	}
+	return 0.0f;
+}
+
+float PacingStats::jitterMs() const noexcept {
+	if (intervalMs.empty()) { return 0.0f; }
+	float sum{};
+	for (std::size_t i = 0; i < intervalMs.size(); ++i) {
+		auto const delta = intervalMs[i] - targetMs;
+		sum += delta * delta;
+	}
+	return std::sqrt(sum / float(intervalMs.size()));
+}
+
+float PacingStats::maxLateMs() const noexcept {
+	float ret{};
+	for (std::size_t i = 0; i < lateMs.size(); ++i) { ret = std::max(ret, lateMs[i]); }
+	return ret;
+}
+
+void showStats(Stats const& stats, bool* open) {
+	ImGui::SetNextWindowSize({320.0f, 300.0f}, ImGuiCond_Once);
+	if (ImGui::Begin("dibs stats", open)) {
+		if (ImGui::CollapsingHeader("Frame", ImGuiTreeNodeFlags_DefaultOpen)) {
+			using Metric = FrameStats::Metric;
+			auto const& frames = stats.frames;
+			ImGui::Text("FPS: %.1f", frames.fps());
+			ImGui::Text("Interval p50 / p95 / p99: %.2f / %.2f / %.2f ms", frames.percentile(Metric::eInterval, 0.50f),
+						frames.percentile(Metric::eInterval, 0.95f), frames.percentile(Metric::eInterval, 0.99f));
+			ImGui::Text("CPU / fence wait (p50): %.2f / %.2f ms", frames.percentile(Metric::eCpu, 0.5f), frames.percentile(Metric::eFenceWait, 0.5f));
+			auto const histogram = frames.histogram(Metric::eInterval);
+			float bins[FrameStats::bins_v];
+			std::copy(histogram.begin(), histogram.end(), bins);
+			ImGui::PlotHistogram("##interval", bins, int(FrameStats::bins_v), 0, "interval (2 ms bins)", 0.0f, FLT_MAX, {0.0f, 60.0f});
+			auto const budgets = frames.budgets();
+			for (std::size_t i = 0; i < budgets.size(); ++i) {
+				ImGui::Text("Over %.1f ms: %llu", budgets[i], static_cast<unsigned long long>(frames.overBudget(i)));
+			}
+			ImGui::Text("Stutters: %llu", static_cast<unsigned long long>(frames.stutterCount()));
+			if (!frames.stutters().empty()) {
+				auto const& stutter = frames.stutters().latest();
+				ImGui::Text("  last: frame %llu, %.2f ms (%s)", static_cast<unsigned long long>(stutter.frame), stutter.ms, phaseName(stutter.phase));
+			}
+		}
+		if (stats.pacing.targetMs > 0.0f && ImGui::CollapsingHeader("Pacing", ImGuiTreeNodeFlags_DefaultOpen)) {
+			auto const& pacing = stats.pacing;
+			ImGui::Text("Target: %.2f ms (%.1f FPS)", pacing.targetMs, 1000.0f / pacing.targetMs);
+			ImGui::Text("Jitter: %.3f ms, max late: %.3f ms", pacing.jitterMs(), pacing.maxLateMs());
+			ImGui::Text("Missed: %llu", static_cast<unsigned long long>(pacing.missed));
+		}
+		if (ImGui::CollapsingHeader("Acquire")) {
+			auto const& acquire = stats.acquire;
+			ImGui::Text("Wait: %.3f ms (mean %.3f, max %.3f)", double(acquire.lastWaitMs), double(acquire.meanWaitMs), double(acquire.maxWaitMs));
+			ImGui::Text("Acquired: %llu, timed out: %llu", static_cast<unsigned long long>(acquire.acquired), static_cast<unsigned long long>(acquire.timeouts));
+		}
+		if (ImGui::CollapsingHeader("Submits")) {
+			auto const& submits = stats.submits;
+			ImGui::Text("Last frame: %u submits, %u batches", submits.submits, submits.batches);
+			ImGui::Text("Total: %llu (%s)", static_cast<unsigned long long>(submits.total), submits.sync2 ? "vkQueueSubmit2" : "vkQueueSubmit");
+		}
+		if (ImGui::CollapsingHeader("Frame arena")) {
+			auto const& arena = stats.arena;
+			ImGui::Text("Used: %.1f KiB (peak %.1f KiB)", double(arena.used) / 1024.0, double(arena.peak) / 1024.0);
+			ImGui::Text("Capacity: %.1f KiB, spilled to heap: %llu", double(arena.capacity) / 1024.0, static_cast<unsigned long long>(arena.spills));
+		}
+		if (stats.frameExport.listening && ImGui::CollapsingHeader("Frame export")) {
+			auto const& exported = stats.frameExport;
+			ImGui::Text("%s (%s), generation %u", exported.connected ? "Connected" : "Listening", exported.external ? "external memory" : "shared memory",
+						exported.generation);
+			ImGui::Text("Exported: %llu, dropped: %llu", static_cast<unsigned long long>(exported.exported), static_cast<unsigned long long>(exported.dropped));
+		}
+		if (ImGui::CollapsingHeader("Frame ring")) {
+			auto const& ring = stats.ring;
+			ImGui::Text("Used: %.1f KiB (peak %.1f KiB)", double(ring.used) / 1024.0, double(ring.peak) / 1024.0);
+			ImGui::Text("Capacity: %.1f KiB, overflows: %llu", double(ring.capacity) / 1024.0, static_cast<unsigned long long>(ring.overflows));
+		}
+		if (ImGui::CollapsingHeader("Memory")) {
+			auto const& memory = stats.memory;
+			auto const mib = [](std::uint64_t const bytes) { return double(bytes) / (1024.0 * 1024.0); };
+			for (std::size_t i = 0; i < memory.heaps.size(); ++i) {
+				auto const& heap = memory.heaps[i];
+				auto const label = ktl::kformat("{} / {} MiB", std::uint64_t(mib(heap.usage)), std::uint64_t(mib(heap.budget)));
+				ImGui::Text("Heap %zu%s", i, heap.deviceLocal ? " (device)" : "");
+				ImGui::SameLine();
+				ImGui::ProgressBar(heap.fraction(), {-1.0f, 0.0f}, label.c_str());
+			}
+			if (!memory.budget) { ImGui::TextUnformatted("No VK_EXT_memory_budget: usage is dibs' own"); }
+			for (auto const& each : memory.footprint) {
+				ImGui::Text("%s%s: %.2f MiB device, %.1f KiB host", each.name, each.estimated ? " (est.)" : "", mib(each.device), double(each.host) / 1024.0);
+			}
+		}
+		if (stats.pipelines.requested > 0U && ImGui::CollapsingHeader("Pipelines")) {
+			auto const& pipelines = stats.pipelines;
+			auto const u = [](std::uint64_t const value) { return static_cast<unsigned long long>(value); };
+			ImGui::Text("Requested: %llu (shared %llu), pending: %llu", u(pipelines.requested), u(pipelines.shared), u(pipelines.pending));
+			ImGui::Text("Compiled: %llu, failed: %llu", u(pipelines.compiled), u(pipelines.failed));
+			ImGui::Text("Compile: %.2f ms mean, %.2f ms max", double(pipelines.meanCompileMs), double(pipelines.maxCompileMs));
+			ImGui::Text("Shader modules: %llu (reused %llu)", u(pipelines.shaderModules), u(pipelines.shaderHits));
+			ImGui::Text("Not ready: %llu uses in %llu frames", u(pipelines.notReady), u(pipelines.hitchFrames));
+		}
+		if (!stats.workers.empty() && ImGui::CollapsingHeader("Jobs")) {
+			for (std::size_t i = 0; i < stats.workers.size(); ++i) {
+				auto const& worker = stats.workers[i];
+				auto const label = ktl::kformat("{} jobs, {} stolen", worker.jobs, worker.steals);
+				ImGui::Text("Worker %zu", i);
+				ImGui::SameLine();
+				ImGui::ProgressBar(worker.busy, {-1.0f, 0.0f}, label.c_str());
+			}
+		}
+		if (ImGui::CollapsingHeader("GPU", ImGuiTreeNodeFlags_DefaultOpen)) {
+			if (stats.gpu.empty()) {
+				ImGui::TextUnformatted("No GPU timings available");
+			} else {
+				auto const& latest = stats.gpu.latest();
+				auto* const history = const_cast<void*>(static_cast<void const*>(&stats.gpu));
+				ImGui::PlotLines("##gpu", &gpuMs, history, int(stats.gpu.size()), 0, nullptr, 0.0f, FLT_MAX, {0.0f, 60.0f});
+				ImGui::Text("Frame:  %.3f ms", latest.ms);
+				ImGui::Text("Passes: %.3f ms", latest.passesMs);
+				ImGui::Text("ImGui:  %.3f ms", latest.imguiMs);
+				for (auto const& region : latest.regions) { ImGui::Text("  %s: %.3f ms", region.label, region.ms); }
+				if (latest.pipeline) {
+					auto const& pipeline = *latest.pipeline;
+					ImGui::Separator();
+					ImGui::Text("Vertices:   %llu", static_cast<unsigned long long>(pipeline.inputAssemblyVertices));
+					ImGui::Text("Primitives: %llu", static_cast<unsigned long long>(pipeline.inputAssemblyPrimitives));
+					ImGui::Text("VS / FS:    %llu / %llu", static_cast<unsigned long long>(pipeline.vertexShaderInvocations),
+								static_cast<unsigned long long>(pipeline.fragmentShaderInvocations));
+					ImGui::Text("CS:         %llu", static_cast<unsigned long long>(pipeline.computeShaderInvocations));
+				}
+			}
+		}
+	}
+	ImGui::End();
+}
+} // namespace dibs
@@ -0,0 +1,12 @@
+#include <detail/task_scheduler.hpp>
+#include <dibs/task.hpp>
+
+namespace dibs {
+void NextFrame::await_suspend(std::coroutine_handle<> const handle) const { m_scheduler->waitFrame(handle); }
+Frame const& NextFrame::await_resume() const noexcept { return m_scheduler->current(); }
+
+bool GpuComplete::await_ready() const noexcept { return m_scheduler->executed(m_frame); }
+void GpuComplete::await_suspend(std::coroutine_handle<> const handle) const { m_scheduler->waitGpu(handle, m_frame); }
+
+void Background::await_suspend(std::coroutine_handle<> const handle) { m_scheduler->run(handle, std::move(m_work)); }
+} // namespace dibs